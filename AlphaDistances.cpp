@@ -8,8 +8,10 @@
 #include <functional>
 #include <vector>
 #include <unordered_set>
+#include <utility>
 #include "AlphaDistances.h"
 #include "PrimsAlgorithm.h"
+#include "Statistics.h"
 
 signed_distance_t OneTree::length(const std::function<signed_distance_t(vertex_t, vertex_t)> &dist) {
     signed_distance_t result = 0;
@@ -83,6 +85,8 @@ OneTree minimumOneTree(dimension_t dimension, const std::function<signed_distanc
 
 std::vector<std::vector<distance_t>>
 alphaDistances(dimension_t dimension, const std::function<signed_distance_t(vertex_t, vertex_t)> &dist) {
+    STATISTICS_TIMER(ALPHA_COMPUTATION);
+
     OneTree tree = minimumOneTree(dimension, dist);
 
     // Initialize the beta array
@@ -131,6 +135,15 @@ alphaDistances(dimension_t dimension, const std::function<signed_distance_t(vert
 
 std::vector<std::vector<distance_t>>
 optimizedAlphaDistances(dimension_t dimension, const std::function<signed_distance_t(vertex_t, vertex_t)> &dist) {
+    std::vector<signed_distance_t> penalties = subgradientPenalties(dimension, dist);
+
+    return alphaDistances(dimension, [&dist, &penalties](vertex_t v, vertex_t w) {
+        return dist(v, w) + penalties[v] + penalties[w];
+    });
+}
+
+std::vector<signed_distance_t>
+subgradientPenalties(dimension_t dimension, const std::function<signed_distance_t(vertex_t, vertex_t)> &dist) {
     // The penalties of each vertex
     std::vector<signed_distance_t> penalties(dimension, 0);
 
@@ -139,74 +152,138 @@ optimizedAlphaDistances(dimension_t dimension, const std::function<signed_distan
         return dist(v, w) + penalties[v] + penalties[w];
     };
 
-    // The minimum 1-tree
-    OneTree tree = minimumOneTree(dimension, modifiedDist);
+    // Only the subgradient optimization is timed, not the rest of the function
+    {
+        STATISTICS_TIMER(SUBGRADIENT_OPTIMIZATION);
 
-    // The lower bound on the size of an optimal tour. This is the objective function we want to maximize
-    auto objectiveFunction = [&tree, &modifiedDist, &penalties]() {
-        signed_distance_t penaltiesSum = 0;
-        for (signed_distance_t p : penalties) {
-            penaltiesSum += p;
-        }
-        return tree.length(modifiedDist) - 2 * penaltiesSum;
-    };
+        // The minimum 1-tree
+        OneTree tree = minimumOneTree(dimension, modifiedDist);
 
-    std::size_t stepSize = 1;
-    std::size_t periodLength = dimension / 2;
-    std::size_t iteration = 0; // A counter for the iterations in the current period
-    signed_distance_t currentObjective = objectiveFunction(); // The current value of the objective function
-    signed_distance_t maxObjective = currentObjective; // The maximum value of the objective function
-    // Used to double the step size in the first period until the objective function does not increase
-    bool doubleStepSize = true;
-
-    // The subgradient vector is the degree of each vertex minus 2
-    std::vector<signed_distance_t> currentSubgradient = tree.degrees();
-    std::transform(currentSubgradient.begin(), currentSubgradient.end(), currentSubgradient.begin(),
-                   [](signed_distance_t d) { return d - 2; });
-    std::vector<signed_distance_t> previousSubgradient = currentSubgradient;
-
-    // Stop the subgradient optimization if the step size the length of the period or the gradient vector is zero
-    while (stepSize != 0 and periodLength != 0 and !std::all_of(currentSubgradient.begin(), currentSubgradient.end(),
-                                                                [](signed_distance_t d) { return d == 0; })) {
-        // Start of the period
-        while (iteration++ < periodLength and !std::all_of(currentSubgradient.begin(), currentSubgradient.end(),
-                                                           [](signed_distance_t d) { return d == 0; })) {
-            // Update the penalties
-            for (std::size_t i = 0; i < penalties.size(); ++i) {
-                penalties[i] += lround(stepSize * (0.7 * currentSubgradient[i] + 0.3 * previousSubgradient[i]));
+        // The lower bound on the size of an optimal tour. This is the objective function we want to maximize
+        auto objectiveFunction = [&tree, &modifiedDist, &penalties]() {
+            signed_distance_t penaltiesSum = 0;
+            for (signed_distance_t p : penalties) {
+                penaltiesSum += p;
             }
+            return tree.length(modifiedDist) - 2 * penaltiesSum;
+        };
+
+        std::size_t stepSize = 1;
+        std::size_t periodLength = dimension / 2;
+        std::size_t iteration = 0; // A counter for the iterations in the current period
+        signed_distance_t currentObjective = objectiveFunction(); // The current value of the objective function
+        signed_distance_t maxObjective = currentObjective; // The maximum value of the objective function
+        // Used to double the step size in the first period until the objective function does not increase
+        bool doubleStepSize = true;
+
+        // The subgradient vector is the degree of each vertex minus 2
+        std::vector<signed_distance_t> currentSubgradient = tree.degrees();
+        std::transform(currentSubgradient.begin(), currentSubgradient.end(), currentSubgradient.begin(),
+                       [](signed_distance_t d) { return d - 2; });
+        std::vector<signed_distance_t> previousSubgradient = currentSubgradient;
+
+        // Stop the subgradient optimization if the step size the length of the period or the gradient vector is zero
+        while (stepSize != 0 and periodLength != 0 and
+               !std::all_of(currentSubgradient.begin(), currentSubgradient.end(),
+                            [](signed_distance_t d) { return d == 0; })) {
+            // Start of the period
+            while (iteration++ < periodLength and !std::all_of(currentSubgradient.begin(), currentSubgradient.end(),
+                                                               [](signed_distance_t d) { return d == 0; })) {
+                STATISTICS_COUNT(SUBGRADIENT_ITERATIONS);
+
+                // Update the penalties
+                for (std::size_t i = 0; i < penalties.size(); ++i) {
+                    penalties[i] += lround(stepSize * (0.7 * currentSubgradient[i] + 0.3 * previousSubgradient[i]));
+                }
 
-            // Update the tree and the subgradient vector
-            tree = minimumOneTree(dimension, modifiedDist);
-            previousSubgradient = currentSubgradient;
-            currentSubgradient = tree.degrees();
-            std::transform(currentSubgradient.begin(), currentSubgradient.end(), currentSubgradient.begin(),
-                           [](signed_distance_t d) { return d - 2; });
-            currentObjective = objectiveFunction();
-
-            // In the first period the step size is doubled until the objective function does not increase
-            if (doubleStepSize) {
-                if (currentObjective > maxObjective) {
-                    stepSize *= 2;
-                } else {
-                    doubleStepSize = false;
+                // Update the tree and the subgradient vector
+                tree = minimumOneTree(dimension, modifiedDist);
+                previousSubgradient = currentSubgradient;
+                currentSubgradient = tree.degrees();
+                std::transform(currentSubgradient.begin(), currentSubgradient.end(), currentSubgradient.begin(),
+                               [](signed_distance_t d) { return d - 2; });
+                currentObjective = objectiveFunction();
+
+                // In the first period the step size is doubled until the objective function does not increase
+                if (doubleStepSize) {
+                    if (currentObjective > maxObjective) {
+                        stepSize *= 2;
+                    } else {
+                        doubleStepSize = false;
+                    }
+                }
+
+                // If the last iteration in the period leads to an increase of the objective function the period length
+                // is doubled
+                if (iteration + 1 == periodLength and currentObjective > maxObjective) {
+                    periodLength *= 2;
                 }
-            }
 
-            // If the last iteration in the period leads to an increase of the objective function the period length is
-            // doubled
-            if (iteration + 1 == periodLength and currentObjective > maxObjective) {
-                periodLength *= 2;
+                maxObjective = std::max(maxObjective, currentObjective);
             }
 
-            maxObjective = std::max(maxObjective, currentObjective);
+            // End of the period
+            stepSize /= 2;
+            periodLength /= 2;
+            iteration = 0;
         }
+    }
+
+    return penalties;
+}
+
+// ======================================== StreamingAlphaDistances class ==============================================
 
-        // End of the period
-        stepSize /= 2;
-        periodLength /= 2;
-        iteration = 0;
+StreamingAlphaDistances::StreamingAlphaDistances(dimension_t dimension,
+                                                 std::function<signed_distance_t(vertex_t, vertex_t)> dist)
+        : dimension(dimension), dist(std::move(dist)), parentDistance(dimension, 0), beta(dimension, 0),
+          pathMark(dimension, dimension) {
+    STATISTICS_TIMER(ALPHA_COMPUTATION);
+
+    tree = minimumOneTree(dimension, this->dist);
+    for (auto v = tree.topologicalOrder.begin() + 1; v != tree.topologicalOrder.end(); ++v) {
+        parentDistance[*v] = this->dist(*v, tree.parent[*v]);
+    }
+
+    // No row is computed yet
+    row = dimension;
+}
+
+void StreamingAlphaDistances::computeRow(vertex_t v) {
+    row = v;
+
+    // The beta values of the edges (special, w) are chosen as in alphaDistances
+    const signed_distance_t specialNeighborDistance = dist(tree.special, tree.specialNeighbor);
+    if (v == tree.special) {
+        std::fill(beta.begin(), beta.end(), specialNeighborDistance);
+        beta[tree.parent[tree.special]] = parentDistance[tree.special];
+        beta[tree.special] = 0;
+        return;
+    }
+
+    // On the path from v to the root beta is the maximum edge length on the path so far, the special vertex is a leaf
+    // of the tree and never on this path
+    beta[v] = 0;
+    pathMark[v] = v;
+    for (vertex_t w = v; w != tree.topologicalOrder.front(); w = tree.parent[w]) {
+        beta[tree.parent[w]] = std::max(beta[w], parentDistance[w]);
+        pathMark[tree.parent[w]] = v;
+    }
+
+    // Every other vertex w comes after its parent in the topological order, and the path from v to w ends with the
+    // edge (parent[w], w)
+    for (vertex_t w : tree.topologicalOrder) {
+        if (pathMark[w] != v and w != tree.special) {
+            beta[w] = std::max(beta[tree.parent[w]], parentDistance[w]);
+        }
     }
 
-    return alphaDistances(dimension, modifiedDist);
+    beta[tree.special] = v == tree.parent[tree.special] ? parentDistance[tree.special] : specialNeighborDistance;
+}
+
+distance_t StreamingAlphaDistances::operator()(vertex_t v, vertex_t w) {
+    if (v != row) {
+        computeRow(v);
+    }
+    return static_cast<distance_t>(dist(v, w) - beta[w]);
 }
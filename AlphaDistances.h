@@ -55,4 +55,44 @@ alphaDistances(dimension_t dimension, const std::function<signed_distance_t(vert
 std::vector<std::vector<distance_t>>
 optimizedAlphaDistances(dimension_t dimension, const std::function<signed_distance_t(vertex_t, vertex_t)> &dist);
 
+// Computes the penalties of all vertices used by optimizedAlphaDistances with subgradient optimization, the modified
+// distance of i and j is dist(i, j) + penalties[i] + penalties[j]
+std::vector<signed_distance_t>
+subgradientPenalties(dimension_t dimension, const std::function<signed_distance_t(vertex_t, vertex_t)> &dist);
+
+// ======================================== StreamingAlphaDistances class ==============================================
+
+// This class computes the same alpha distances as alphaDistances, but without storing the dimension x dimension
+// tables alpha and beta. Only the beta values of one row are kept, they are recomputed in O(dimension) time whenever a
+// value of another row is requested. So the values should be requested row by row, e.g. to select the candidate edges
+// of one vertex after another.
+
+class StreamingAlphaDistances {
+private:
+    dimension_t dimension;
+    std::function<signed_distance_t(vertex_t, vertex_t)> dist;
+
+    // The minimum 1-tree and the length of the edge (v, parent[v]) for every vertex v except the root of the tree
+    OneTree tree;
+    std::vector<signed_distance_t> parentDistance;
+
+    // beta[w] is the length of the edge in the 1-tree that needs to be removed when (row, w) is inserted
+    vertex_t row;
+    std::vector<signed_distance_t> beta;
+
+    // Marks the vertices on the path from row to the root of the tree, the mark of a vertex v is the last row for which
+    // v was on this path
+    std::vector<vertex_t> pathMark;
+
+    // Computes beta for the vertex v
+    void computeRow(vertex_t v);
+
+public:
+    // Computes the minimum 1-tree in the complete graph with dimension vertices and edge weights given by dist
+    StreamingAlphaDistances(dimension_t dimension, std::function<signed_distance_t(vertex_t, vertex_t)> dist);
+
+    // Returns the alpha distance of v and w
+    distance_t operator()(vertex_t v, vertex_t w);
+};
+
 #endif //LINKERNIGHANALGORITHM_ALPHADISTANCES_H
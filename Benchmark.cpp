@@ -0,0 +1,616 @@
+// This program runs the Lin-Kernighan-heuristic on a suite of TSPLIB problems with known optimum tour lengths and fixed
+// seeds. For every run it records the final gap to the optimum, the time until a tour within the acceptable error was
+// found (time-to-target) and the running time of every phase (see Statistics.h). The results are written to a JSON
+// report and compared to a baseline report, so that performance regressions are noticed.
+// With --tune the runs of the suite are used to race a grid of parameter configurations against each other instead (see
+// tune), the configuration with the best time-to-target is printed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Solver.h"
+#include "Statistics.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+const std::string helpString = R""(
+Usage:
+    LinKernighanBenchmark --help
+    LinKernighanBenchmark suite_file report_file [options]
+
+Each non-empty line of the suite file that does not start with # describes one benchmark:
+    label tsplib_problem.tsp optimum [benchmark options]
+where optimum is either the optimum tour length or a TSPLIB tour file with an optimum tour. The paths are relative to
+the working directory.
+
+Benchmark options:
+    --seeds=integer,integer,...
+        Run the benchmark once for every seed (default: 1)
+    --number-of-trials=integer
+    --candidate-edges=[ALL|NEAREST|ALPHA_NEAREST|OPT_ALPHA_NEAREST]
+    --number-of-candidate-edges=integer
+    --dont-store-distances
+    --distance-cache-mb=integer
+    --memory-limit=integer
+    --renumber-vertices
+    --merge-duplicates
+    --mode=[LK|FAST|FAST_LK]
+    --move-type=[LK|5OPT]
+    --backtracking-depth=integer
+    --infeasibility-depth=integer
+    --max-move-depth=integer
+    --candidate-order=[REVERSE_ALPHA|ALPHA|LOOKAHEAD]
+    --breadth=integer,integer,...
+    --group-size=integer
+    --tour-merging
+    --backbone-tours=integer
+    --fix-backbone
+    --dont-look-bits
+    --partition-size=integer
+    --multilevel=integer
+    --segment-size=integer
+    --window-size=integer
+    --threads=integer
+    --acceptable-error=double
+        The same as for LinKernighanAlgorithm. A tour within the acceptable error is the target of the time-to-target.
+
+Options:
+    --baseline=file
+        Compare the results to the report in file. The program fails if a run is missing in the report or its gap
+        increased by more than the gap tolerance.
+    --check-time
+        Also fail if the running time of a run increased by more than the time tolerance. The running times depend on
+        the machine, so the baseline must have been made on the same machine (see the target bench-time).
+    --gap-tolerance=double
+        The allowed increase of the gap in percentage points (default: 0.5)
+    --time-tolerance=double
+        The allowed relative increase of the running time in percent. Increases of less than 0.1 seconds are always
+        allowed to ignore measurement noise on small problems. (default: 30)
+    --tune
+        Race a grid of configurations of the candidate edges, the number of candidate edges, the backtracking depth,
+        the breadth and the group size on the runs of the suite. Every run of the suite is performed with every
+        configuration that is still in the race, the options of the suite line are used for everything else.
+        Configurations that are significantly worse by time-to-target (then gap and running time) are eliminated.
+        The options of the best configuration are printed and the report contains the mean rank of every
+        configuration. The baseline options are ignored.
+    --tune-min-runs=integer
+        The number of runs of the suite after which configurations are eliminated for the first time. (default: 3)
+)"";
+
+// A single run of the heuristic as described by a line of the suite file
+struct BenchmarkRun {
+    std::string label;
+    std::string problemFileName;
+    std::string optimum;
+    SolverOptions options;
+};
+
+// The result of a BenchmarkRun
+struct BenchmarkResult {
+    dimension_t dimension = 0;
+    distance_t optimumTourLength = 0;
+    distance_t length = 0;
+    double gap = 0; // in percent
+    double timeToTarget = -1; // in seconds, negative if the target was not reached
+    double totalTime = 0; // in seconds
+    std::size_t duplicateTrials = 0; // The number of trials that found the tour of an earlier trial
+    double phaseTimes[Statistics::NUMBER_OF_PHASES] = {};
+};
+
+// Read the suite file and return all runs described in it
+// Returns an error message if an error occurred and an empty string otherwise
+std::string readSuite(std::ifstream &suiteFile, std::vector<BenchmarkRun> &runs) {
+    std::string line;
+    while (std::getline(suiteFile, line)) {
+        line = trim(line);
+        if (line.empty() or line[0] == '#') {
+            continue;
+        }
+
+        std::stringstream lineStream(line);
+        BenchmarkRun run;
+        if (!(lineStream >> run.label >> run.problemFileName >> run.optimum)) {
+            return "Expected a label, a TSPLIB file and an optimum in the line '" + line + "'";
+        }
+
+        std::vector<std::mt19937::result_type> seeds{1};
+        std::string argument;
+        std::string option;
+        while (lineStream >> argument) {
+            std::stringstream stringStream(argument);
+            std::getline(stringStream, option, '=');
+            if (option == "--seeds") {
+                seeds.clear();
+                std::mt19937::result_type seed;
+                while (stringStream >> seed) {
+                    seeds.push_back(seed);
+                    stringStream.ignore(1, ',');
+                }
+                stringStream.clear();
+            } else {
+                const std::string errorMessage = run.options.readOption(option, stringStream);
+                if (!errorMessage.empty()) {
+                    return errorMessage + " in the line '" + line + "'";
+                }
+            }
+            if (stringStream.fail() or seeds.empty()) {
+                return "The option '" + argument + "' has an invalid format";
+            }
+        }
+
+        const std::string errorMessage = run.options.validate();
+        if (!errorMessage.empty()) {
+            return errorMessage + " in the line '" + line + "'";
+        }
+
+        const std::string label = run.label;
+        for (std::mt19937::result_type seed : seeds) {
+            run.label = label + "#" + std::to_string(seed);
+            run.options.seed = seed;
+            runs.push_back(run);
+        }
+    }
+    return "";
+}
+
+// Perform run and store the result in result
+// Returns an error message if an error occurred and an empty string otherwise
+std::string performRun(const BenchmarkRun &run, BenchmarkResult &result) {
+    Statistics::reset();
+    const auto startTime = std::chrono::steady_clock::now();
+
+    TsplibProblem problem;
+    std::string errorMessage = readProblem(run.problemFileName, run.options, problem);
+    if (!errorMessage.empty()) {
+        return errorMessage;
+    }
+    result.dimension = problem.getDimension();
+
+    // The optimum is either a number or an optimum tour, it uses the original vertices, so it is read before solve
+    // merges and renumbers them
+    if (run.optimum.find_first_not_of("0123456789") == std::string::npos) {
+        result.optimumTourLength = std::stoul(run.optimum);
+    } else {
+        std::ifstream tourFile(run.optimum);
+        TsplibTour optimumTour;
+        if (!tourFile.is_open() or !(errorMessage = optimumTour.readFile(tourFile)).empty()) {
+            return "Could not read the optimum tour '" + run.optimum + "': " + errorMessage;
+        }
+        if (optimumTour.getDimension() != problem.getDimension()) {
+            return "The optimum tour '" + run.optimum + "' does not fit to the TSPLIB problem";
+        }
+        result.optimumTourLength = problem.length(optimumTour);
+    }
+
+    SolverOptions options = run.options;
+    options.optimumTourLength = result.optimumTourLength;
+    const SolverResult solverResult = solve(problem, options, false);
+    const double targetLength = (1 + options.acceptableError / 100) * result.optimumTourLength;
+    const std::chrono::duration<double> preprocessingTime = solverResult.searchStartTime - startTime;
+    for (const LinKernighanHeuristic::Improvement &improvement : solverResult.improvements) {
+        if (improvement.length <= targetLength) {
+            result.timeToTarget = preprocessingTime.count() + improvement.seconds;
+            break;
+        }
+    }
+    result.duplicateTrials = solverResult.duplicateTrials;
+    const std::chrono::duration<double> totalTime = std::chrono::steady_clock::now() - startTime;
+    result.length = problem.length(solverResult.tour);
+    result.totalTime = totalTime.count();
+    // The exact, partitioned and multi-level solvers and the segment and window optimizations have no trials of the
+    // whole problem, so their time-to-target is the total time
+    if (result.timeToTarget < 0 and result.length <= targetLength) {
+        result.timeToTarget = result.totalTime;
+    }
+    result.gap = (result.length / static_cast<double>(result.optimumTourLength) - 1) * 100;
+    for (std::size_t phase = 0; phase < Statistics::NUMBER_OF_PHASES; ++phase) {
+        result.phaseTimes[phase] = Statistics::getSeconds(static_cast<Statistics::Phase>(phase));
+    }
+    return "";
+}
+
+// Converts run and result to a JSON object in a single line
+std::string toJson(const BenchmarkRun &run, const BenchmarkResult &result) {
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\"label\": \"" << run.label << "\", \"problem\": \"" << run.problemFileName << "\", \"seed\": "
+         << run.options.seed << ", \"dimension\": " << result.dimension << ", \"optimum\": " << result.optimumTourLength
+         << ", \"length\": " << result.length << ", \"gap_percent\": " << result.gap
+         << ", \"time_to_target_seconds\": ";
+    if (result.timeToTarget >= 0) {
+        json << result.timeToTarget;
+    } else {
+        json << "null";
+    }
+    json << ", \"total_seconds\": " << result.totalTime << ", \"duplicate_trials\": " << result.duplicateTrials
+         << ", \"phases\": {";
+    for (std::size_t phase = 0; phase < Statistics::NUMBER_OF_PHASES; ++phase) {
+        json << (phase == 0 ? "" : ", ") << "\"" << Statistics::getName(static_cast<Statistics::Phase>(phase))
+             << "\": " << result.phaseTimes[phase];
+    }
+    json << "}}";
+    return json.str();
+}
+
+// Returns the number after "key": in the JSON line or defaultValue if it does not exist
+double readJsonNumber(const std::string &line, const std::string &key, double defaultValue) {
+    std::string::size_type index = line.find("\"" + key + "\": ");
+    if (index == std::string::npos) {
+        return defaultValue;
+    }
+    std::stringstream stream(line.substr(index + key.size() + 4));
+    double value;
+    return (stream >> value) ? value : defaultValue;
+}
+
+// Reads the gap and the total running time of every run in a report written by this program
+std::map<std::string, BenchmarkResult> readBaseline(std::ifstream &baselineFile) {
+    std::map<std::string, BenchmarkResult> baseline;
+    std::string line;
+    const std::string labelKey = "{\"label\": \"";
+    while (std::getline(baselineFile, line)) {
+        std::string::size_type start = line.find(labelKey);
+        if (start == std::string::npos) {
+            continue;
+        }
+        start += labelKey.size();
+        std::string label = line.substr(start, line.find('"', start) - start);
+        BenchmarkResult &result = baseline[label];
+        result.gap = readJsonNumber(line, "gap_percent", 0);
+        result.totalTime = readJsonNumber(line, "total_seconds", 0);
+    }
+    return baseline;
+}
+
+// A combination of the parameters that are tuned, see tune
+struct TuningConfiguration {
+    CandidateEdges::Type candidateEdgeType;
+    std::size_t numberOfCandidateEdges;
+    std::size_t backtrackingDepth;
+    std::vector<std::size_t> breadth;
+    dimension_t groupSize;
+
+    // Override the tuned parameters of run
+    void applyTo(BenchmarkRun &run) const {
+        run.options.candidateEdgeType = candidateEdgeType;
+        run.options.numberOfCandidateEdges = numberOfCandidateEdges;
+        run.options.parameters.backtrackingDepth = backtrackingDepth;
+        run.options.parameters.breadth = breadth;
+        run.options.parameters.groupSize = groupSize;
+    }
+
+    // Returns the configuration as options of a suite line or of LinKernighanAlgorithm
+    std::string toString() const {
+        const char *candidateEdgeNames[] = {"ALL", "NEAREST", "ALPHA_NEAREST", "OPT_ALPHA_NEAREST"};
+        std::ostringstream options;
+        options << "--candidate-edges=" << candidateEdgeNames[candidateEdgeType] << " --number-of-candidate-edges="
+                << numberOfCandidateEdges << " --backtracking-depth=" << backtrackingDepth;
+        for (std::size_t i = 0; i < breadth.size(); ++i) {
+            options << (i == 0 ? " --breadth=" : ",") << breadth[i];
+        }
+        if (groupSize != 0) {
+            options << " --group-size=" << groupSize;
+        }
+        return options.str();
+    }
+};
+
+// Returns all configurations that are raced by tune
+// There is only one way to construct the start tours (see LinKernighanHeuristic::generateRandomTour), so it is not
+// part of the configurations
+std::vector<TuningConfiguration> tuningConfigurations() {
+    std::vector<TuningConfiguration> configurations;
+    for (CandidateEdges::Type candidateEdgeType : {CandidateEdges::NEAREST_NEIGHBORS,
+                                                   CandidateEdges::ALPHA_NEAREST_NEIGHBORS,
+                                                   CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS}) {
+        for (std::size_t numberOfCandidateEdges : {5, 8, 10}) {
+            for (std::size_t backtrackingDepth : {2, 3, 5}) {
+                for (const std::vector<std::size_t> &breadth : {std::vector<std::size_t>{},
+                                                                std::vector<std::size_t>{5, 3, 1},
+                                                                std::vector<std::size_t>{3, 2, 1}}) {
+                    for (dimension_t groupSize : {0, 25, 100}) {
+                        configurations.push_back(TuningConfiguration{candidateEdgeType, numberOfCandidateEdges,
+                                                                     backtrackingDepth, breadth, groupSize});
+                    }
+                }
+            }
+        }
+    }
+    return configurations;
+}
+
+// Returns whether result1 is better than result2: a reached target in less time, then a smaller gap and then a smaller
+// running time
+bool isBetterResult(const BenchmarkResult &result1, const BenchmarkResult &result2) {
+    const bool reached1 = result1.timeToTarget >= 0;
+    const bool reached2 = result2.timeToTarget >= 0;
+    if (reached1 != reached2) {
+        return reached1;
+    }
+    if (reached1 and result1.timeToTarget != result2.timeToTarget) {
+        return result1.timeToTarget < result2.timeToTarget;
+    }
+    if (result1.gap != result2.gap) {
+        return result1.gap < result2.gap;
+    }
+    return result1.totalTime < result2.totalTime;
+}
+
+// Returns the p-quantile of the chi-squared distribution with degreesOfFreedom degrees of freedom by the approximation
+// of Wilson and Hilferty, z is the p-quantile of the standard normal distribution
+double chiSquaredQuantile(double degreesOfFreedom, double z) {
+    const double k = 2 / (9 * degreesOfFreedom);
+    return degreesOfFreedom * std::pow(1 - k + z * std::sqrt(k), 3);
+}
+
+// Returns the p-quantile of the studentized range of m independent standard normal variables (infinite degrees of
+// freedom). The distribution function P(range <= q) = m * integral of phi(z) * (Phi(z + q) - Phi(z))^(m - 1) dz is
+// integrated by Simpson's rule and the quantile is found by bisection
+double studentizedRangeQuantile(std::size_t m, double p) {
+    auto normalDistribution = [](double z) {
+        return 0.5 * std::erfc(-z / std::sqrt(2.0));
+    };
+    auto rangeDistribution = [&](double q) {
+        const double lower = -8, upper = 8;
+        const std::size_t steps = 800; // even
+        const double h = (upper - lower) / steps;
+        double sum = 0;
+        for (std::size_t i = 0; i <= steps; ++i) {
+            const double z = lower + i * h;
+            const double density = std::exp(-z * z / 2) / std::sqrt(2 * std::acos(-1.0));
+            const double value = density * std::pow(normalDistribution(z + q) - normalDistribution(z),
+                                                    static_cast<double>(m - 1));
+            sum += (i == 0 or i == steps ? 1 : (i % 2 == 1 ? 4 : 2)) * value;
+        }
+        return static_cast<double>(m) * sum * h / 3;
+    };
+    double low = 0, high = 20;
+    for (std::size_t iteration = 0; iteration < 50; ++iteration) {
+        const double middle = (low + high) / 2;
+        (rangeDistribution(middle) < p ? low : high) = middle;
+    }
+    return (low + high) / 2;
+}
+
+// Race the configurations of tuningConfigurations on runs and write the mean rank of every configuration to
+// reportFile. This is the F-Race of Birattari et al.: the runs are performed one after another with every
+// configuration that is still in the race, and after every run the configurations are ranked in every run so far (1 is
+// the best, see isBetterResult, ties get the mean rank). From minimumRuns runs on, the Friedman test checks whether the
+// m configurations differ at all, i.e. whether its statistic 12n / (m(m + 1)) * sum of (R_c - (m + 1) / 2)^2 for the
+// mean ranks R_c of n runs exceeds the 95% quantile of the chi-squared distribution with m - 1 degrees of freedom. Only
+// then the configurations whose mean rank is worse than the best one by more than the critical difference
+// q(m) / sqrt(2) * sqrt(m(m + 1) / (6n)) of Nemenyi's test are eliminated, q(m) is the 95% quantile of the studentized
+// range of m configurations. Both tests have a significance level of 5% and ignore the correction for ties, which only
+// makes them more conservative.
+// Returns an error message if an error occurred and an empty string otherwise
+std::string tune(const std::vector<BenchmarkRun> &runs, std::size_t minimumRuns, std::ofstream &reportFile) {
+    const std::vector<TuningConfiguration> configurations = tuningConfigurations();
+    // results[c][r] is the result of run r with configuration c, eliminatedAfter[c] the number of runs after which
+    // configuration c was eliminated or 0 if it is still in the race
+    std::vector<std::vector<BenchmarkResult>> results(configurations.size());
+    std::vector<std::size_t> eliminatedAfter(configurations.size(), 0);
+    std::vector<std::size_t> alive(configurations.size());
+    std::iota(alive.begin(), alive.end(), 0);
+    std::vector<double> meanRanks(configurations.size(), 0);
+
+    for (std::size_t r = 0; r < runs.size() and alive.size() > 1; ++r) {
+        for (std::size_t c : alive) {
+            BenchmarkRun run = runs[r];
+            configurations[c].applyTo(run);
+            BenchmarkResult result;
+            std::string errorMessage = performRun(run, result);
+            if (!errorMessage.empty()) {
+                return run.label + ": " + errorMessage;
+            }
+            results[c].push_back(result);
+        }
+
+        // Rank the configurations that are still in the race in every run so far, the eliminated configurations keep
+        // their last mean rank
+        for (std::size_t c : alive) {
+            meanRanks[c] = 0;
+        }
+        for (std::size_t i = 0; i <= r; ++i) {
+            std::vector<std::size_t> order(alive);
+            std::sort(order.begin(), order.end(), [&results, i](std::size_t c1, std::size_t c2) {
+                return isBetterResult(results[c1][i], results[c2][i]);
+            });
+            for (std::size_t first = 0, last; first < order.size(); first = last) {
+                last = first + 1;
+                while (last < order.size() and !isBetterResult(results[order[first]][i], results[order[last]][i])) {
+                    ++last;
+                }
+                // The tied configurations order[first], ..., order[last - 1] get the mean of the ranks first + 1, ...,
+                // last
+                for (std::size_t j = first; j < last; ++j) {
+                    meanRanks[order[j]] += (first + last + 1) / 2.0 / (r + 1);
+                }
+            }
+        }
+
+        std::size_t best = *std::min_element(alive.begin(), alive.end(), [&meanRanks](std::size_t c1, std::size_t c2) {
+            return meanRanks[c1] < meanRanks[c2];
+        });
+        std::cout << "run " << std::setw(20) << runs[r].label << " configurations " << std::setw(5) << alive.size()
+                  << " best " << configurations[best].toString() << std::endl;
+        if (r + 1 < minimumRuns) {
+            continue;
+        }
+        const double m = alive.size();
+        const double n = r + 1;
+        double friedmanStatistic = 0;
+        for (std::size_t c : alive) {
+            friedmanStatistic += (meanRanks[c] - (m + 1) / 2) * (meanRanks[c] - (m + 1) / 2);
+        }
+        friedmanStatistic *= 12 * n / (m * (m + 1));
+        if (friedmanStatistic <= chiSquaredQuantile(m - 1, 1.6449)) {
+            continue; // The configurations are not significantly different
+        }
+        const double criticalDifference = studentizedRangeQuantile(alive.size(), 0.95) / std::sqrt(2.0) *
+                                          std::sqrt(m * (m + 1) / (6 * n));
+        alive.erase(std::remove_if(alive.begin(), alive.end(), [&](std::size_t c) {
+            if (meanRanks[c] - meanRanks[best] > criticalDifference) {
+                eliminatedAfter[c] = r + 1;
+                return true;
+            }
+            return false;
+        }), alive.end());
+    }
+
+    std::sort(alive.begin(), alive.end(), [&meanRanks](std::size_t c1, std::size_t c2) {
+        return meanRanks[c1] < meanRanks[c2];
+    });
+    std::cout << "The best configuration is " << configurations[alive.front()].toString() << std::endl;
+
+    reportFile << std::setprecision(6) << "{\n  \"best\": \"" << configurations[alive.front()].toString()
+               << "\",\n  \"configurations\": [\n";
+    for (std::size_t c = 0; c < configurations.size(); ++c) {
+        reportFile << "    {\"options\": \"" << configurations[c].toString() << "\", \"runs\": " << results[c].size()
+                   << ", \"mean_rank\": " << meanRanks[c] << ", \"eliminated\": "
+                   << (eliminatedAfter[c] != 0 ? "true" : "false") << "}"
+                   << (c + 1 < configurations.size() ? ",\n" : "\n");
+    }
+    reportFile << "  ]\n}\n";
+    return "";
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 and strcmp(argv[1], "--help") == 0) {
+        std::cout << helpString;
+        return 0;
+    } else if (argc < 3) {
+        std::cerr << "No suite file or report file was supplied." << std::endl;
+        std::cout << helpString;
+        return 1;
+    }
+
+    std::string baselineFileName;
+    double gapTolerance = 0.5;
+    double timeTolerance = 30;
+    bool checkTime = false;
+    bool tuneParameters = false;
+    std::size_t minimumTuningRuns = 3;
+
+    std::stringstream stringStream;
+    std::string option;
+    for (int i = 3; i < argc; ++i) {
+        stringStream << argv[i];
+        std::getline(stringStream, option, '=');
+        if (option == "--baseline") {
+            std::getline(stringStream, baselineFileName);
+        } else if (option == "--gap-tolerance") {
+            stringStream >> gapTolerance;
+        } else if (option == "--time-tolerance") {
+            stringStream >> timeTolerance;
+        } else if (option == "--check-time") {
+            checkTime = true;
+        } else if (option == "--tune") {
+            tuneParameters = true;
+        } else if (option == "--tune-min-runs") {
+            stringStream >> minimumTuningRuns;
+        } else {
+            std::cerr << "An unknown option was given" << std::endl;
+            std::cout << helpString;
+            return 1;
+        }
+        if (stringStream.fail()) {
+            std::cerr << "One of the options has an invalid format" << std::endl;
+            std::cout << helpString;
+            return 1;
+        }
+        stringStream.clear();
+    }
+
+    std::ifstream suiteFile(argv[1]);
+    if (!suiteFile.is_open()) {
+        std::cerr << "Could not open the suite file '" << argv[1] << "'" << std::endl;
+        return 1;
+    }
+    std::vector<BenchmarkRun> runs;
+    std::string errorMessage = readSuite(suiteFile, runs);
+    if (!errorMessage.empty()) {
+        std::cerr << "The suite file has an invalid format: " << errorMessage << std::endl;
+        return 1;
+    }
+
+    if (tuneParameters) {
+        std::ofstream reportFile(argv[2]);
+        errorMessage = tune(runs, minimumTuningRuns, reportFile);
+        if (!errorMessage.empty()) {
+            std::cerr << errorMessage << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::map<std::string, BenchmarkResult> baseline;
+    if (!baselineFileName.empty()) {
+        std::ifstream baselineFile(baselineFileName);
+        if (!baselineFile.is_open()) {
+            std::cerr << "Could not open the baseline file '" << baselineFileName << "'" << std::endl;
+            return 1;
+        }
+        baseline = readBaseline(baselineFile);
+    }
+
+    std::ofstream reportFile(argv[2]);
+    reportFile << "{\n  \"runs\": [\n";
+    std::size_t numberOfRegressions = 0;
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        const BenchmarkRun &run = runs[i];
+        BenchmarkResult result;
+        errorMessage = performRun(run, result);
+        if (!errorMessage.empty()) {
+            std::cerr << run.label << ": " << errorMessage << std::endl;
+            return 1;
+        }
+        reportFile << "    " << toJson(run, result) << (i + 1 < runs.size() ? ",\n" : "\n");
+
+        std::cout << std::left << std::setw(20) << run.label << " gap " << std::setw(10) << result.gap
+                  << " time " << std::setw(10) << result.totalTime << " time-to-target ";
+        if (result.timeToTarget >= 0) {
+            std::cout << result.timeToTarget << std::endl;
+        } else {
+            std::cout << "-" << std::endl;
+        }
+
+        if (!baselineFileName.empty()) {
+            auto baselineResult = baseline.find(run.label);
+            if (baselineResult == baseline.end()) {
+                std::cout << "    REGRESSION: the run is missing in the baseline" << std::endl;
+                numberOfRegressions++;
+                continue;
+            }
+            if (result.gap > baselineResult->second.gap + gapTolerance) {
+                std::cout << "    REGRESSION: the gap increased from " << baselineResult->second.gap << std::endl;
+                numberOfRegressions++;
+            }
+            if (checkTime and result.totalTime > baselineResult->second.totalTime * (1 + timeTolerance / 100) and
+                result.totalTime > baselineResult->second.totalTime + 0.1) {
+                std::cout << "    REGRESSION: the running time increased from " << baselineResult->second.totalTime
+                          << std::endl;
+                numberOfRegressions++;
+            }
+        }
+    }
+    reportFile << "  ]\n}\n";
+    reportFile.close();
+
+    if (numberOfRegressions > 0) {
+        std::cerr << numberOfRegressions << " regressions compared to the baseline were found" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "DistanceCache.h"
+
+DistanceCache::DistanceCache(dimension_t dimension, std::size_t maxBytes) : dimension(dimension), maxBytes(maxBytes) {
+    allocateEntries();
+}
+
+void DistanceCache::allocateEntries() {
+    // The largest key is (dimension - 2) * dimension + dimension, it needs keyBits bits
+    unsigned int keyBits = 1;
+    while (keyBits < 64 and (std::uint64_t(1) << keyBits) <= static_cast<std::uint64_t>(dimension) * dimension) {
+        keyBits++;
+    }
+    valueBits = 64 - keyBits;
+
+    const std::size_t neighborBytes = neighborOffsets.size() * sizeof(std::size_t) +
+                                      neighbors.size() * (sizeof(vertex_t) + sizeof(distance_t));
+    const std::size_t availableEntries = maxBytes > neighborBytes
+                                         ? (maxBytes - neighborBytes) / sizeof(std::atomic<std::uint64_t>) : 0;
+
+    // Only cache distances if at least 16 bits are left for them
+    numberOfSets = 0;
+    if (valueBits >= 16) {
+        numberOfSets = 1;
+        while (2 * numberOfSets * WAYS <= availableEntries) {
+            numberOfSets *= 2;
+        }
+        if (numberOfSets * WAYS > availableEntries) {
+            numberOfSets = 0;
+        }
+    }
+
+    entries.reset(numberOfSets > 0 ? new std::atomic<std::uint64_t>[numberOfSets * WAYS] : nullptr);
+    for (std::size_t index = 0; index < numberOfSets * WAYS; ++index) {
+        entries[index].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef LINKERNIGHANALGORITHM_DISTANCECACHE_H
+#define LINKERNIGHANALGORITHM_DISTANCECACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Statistics.h"
+#include "Tour.h"
+
+// ============================================== DistanceCache class ==================================================
+
+// This class caches distances in a bounded amount of memory. It is a middle ground between storing all distances in a
+// matrix and computing every distance when it is needed. The cache consists of two parts:
+// (1) For every vertex the distances to its candidate neighbors, these are needed most often by the heuristic.
+// (2) A set-associative cache for all other pairs of vertices with a random replacement policy.
+// Each entry of (2) stores the pair of vertices and the distance packed into one 64 bit integer, so the cache can be
+// read and written from several threads at once without locks. Distances that do not fit into an entry are not cached.
+
+class DistanceCache {
+private:
+    // The number of entries in every set of the set-associative cache
+    static const std::size_t WAYS = 4;
+
+    dimension_t dimension;
+
+    // The memory in bytes that may be used by both parts of the cache
+    std::size_t maxBytes;
+
+    // The candidate neighbors of vertex v and their distances are stored in the range
+    // [neighborOffsets[v], neighborOffsets[v + 1]) of neighbors and neighborDistances
+    std::vector<std::size_t> neighborOffsets;
+    std::vector<vertex_t> neighbors;
+    std::vector<distance_t> neighborDistances;
+
+    // The set-associative cache with numberOfSets * WAYS entries, numberOfSets is a power of two
+    // An entry is (key << valueBits) | distance with key = i * dimension + j + 1 for i < j, so 0 is an empty entry
+    std::unique_ptr<std::atomic<std::uint64_t>[]> entries;
+    std::size_t numberOfSets = 0;
+    unsigned int valueBits = 0;
+
+    // Allocate the set-associative cache with all memory that is not used by the neighbor distances
+    void allocateEntries();
+
+    // A hash function with good mixing of all bits (the finalizer of splitmix64)
+    static std::uint64_t hash(std::uint64_t key) {
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+
+    // Returns a pseudo-random way of a set (xorshift32 with a state per thread, so the threads do not share it)
+    static std::size_t randomWay() {
+        static thread_local std::uint32_t state = 2463534242u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 16) % WAYS;
+    }
+
+    // Returns the distance of i and j from the candidate neighbors of i or j
+    // Returns false if it is not found
+    bool findNeighborDistance(vertex_t i, vertex_t j, distance_t &distance) const {
+        if (neighborOffsets.empty()) {
+            return false;
+        }
+        for (std::size_t index = neighborOffsets[i]; index < neighborOffsets[i + 1]; ++index) {
+            if (neighbors[index] == j) {
+                distance = neighborDistances[index];
+                return true;
+            }
+        }
+        for (std::size_t index = neighborOffsets[j]; index < neighborOffsets[j + 1]; ++index) {
+            if (neighbors[index] == i) {
+                distance = neighborDistances[index];
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    // Create a cache for a problem with dimension vertices that uses at most maxBytes bytes
+    DistanceCache(dimension_t dimension, std::size_t maxBytes);
+
+    // Store the distances of every vertex to its neighbors permanently, the rest of the memory is used for the
+    // set-associative cache (which is cleared)
+    // computeDistance(i, j) has to return the distance of i and j
+    template<class ComputeDistance>
+    void setNeighbors(const std::vector<std::vector<vertex_t>> &candidateNeighbors, ComputeDistance computeDistance) {
+        neighborOffsets.assign(1, 0);
+        neighbors.clear();
+        neighborDistances.clear();
+        for (vertex_t v = 0; v < candidateNeighbors.size(); ++v) {
+            for (vertex_t w : candidateNeighbors[v]) {
+                neighbors.push_back(w);
+                neighborDistances.push_back(computeDistance(v, w));
+            }
+            neighborOffsets.push_back(neighbors.size());
+        }
+        allocateEntries();
+    }
+
+    // Returns the distance of i and j, if it is not cached it is computed with computeDistance(i, j) and stored
+    template<class ComputeDistance>
+    distance_t get(vertex_t i, vertex_t j, ComputeDistance computeDistance) const {
+        distance_t distance;
+        if (findNeighborDistance(i, j, distance)) {
+            STATISTICS_COUNT(DISTANCE_CACHE_HITS);
+            return distance;
+        }
+        if (numberOfSets == 0) {
+            STATISTICS_COUNT(DISTANCE_CACHE_MISSES);
+            return computeDistance(i, j);
+        }
+
+        if (i > j) {
+            std::swap(i, j);
+        }
+        const std::uint64_t key = static_cast<std::uint64_t>(i) * dimension + j + 1;
+        const std::uint64_t hashValue = hash(key);
+        std::atomic<std::uint64_t> *set = &entries[(hashValue & (numberOfSets - 1)) * WAYS];
+        std::size_t emptyWay = WAYS;
+        for (std::size_t way = 0; way < WAYS; ++way) {
+            const std::uint64_t entry = set[way].load(std::memory_order_relaxed);
+            if ((entry >> valueBits) == key) {
+                STATISTICS_COUNT(DISTANCE_CACHE_HITS);
+                return static_cast<distance_t>(entry & ((std::uint64_t(1) << valueBits) - 1));
+            }
+            if (entry == 0 and emptyWay == WAYS) {
+                emptyWay = way;
+            }
+        }
+
+        STATISTICS_COUNT(DISTANCE_CACHE_MISSES);
+        distance = computeDistance(i, j);
+        if (distance < (std::uint64_t(1) << valueBits)) {
+            // Fill the first empty entry of the set, otherwise replace a random one. The replaced entry must not depend
+            // on the key, otherwise every key could only be stored in one entry of its set
+            const std::size_t way = emptyWay != WAYS ? emptyWay : randomWay();
+            set[way].store((key << valueBits) | distance, std::memory_order_relaxed);
+        }
+        return distance;
+    }
+};
+
+#endif //LINKERNIGHANALGORITHM_DISTANCECACHE_H
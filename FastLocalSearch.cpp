@@ -0,0 +1,157 @@
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "FastLocalSearch.h"
+#include "LinKernighanHeuristic.h"
+#include "Statistics.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================ FastLocalSearch class ==================================================
+
+FastLocalSearch::FastLocalSearch(const TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                                 std::function<bool(vertex_t, vertex_t)> isFixed)
+        : tsplibProblem(tsplibProblem), candidateEdges(candidateEdges), isFixed(std::move(isFixed)) {}
+
+void FastLocalSearch::activate(vertex_t v) {
+    if (!isActive[v]) {
+        isActive[v] = true;
+        activeVertices.push_back(v);
+    }
+}
+
+void FastLocalSearch::makeMove(BaseTour &tour, const AlternatingWalk &closedWalk) {
+    STATISTICS_COUNT_AT_LEVEL(IMPROVING_MOVES, closedWalk.size() / 2);
+    tour.exchange(closedWalk);
+    for (vertex_t v : closedWalk) {
+        activate(v);
+    }
+}
+
+bool FastLocalSearch::improveByTwoOpt(BaseTour &tour, vertex_t t1, vertex_t t2) {
+    // Replace the edges {t1, t2} and {t3, t4} by {t2, t3} and {t4, t1}, where {t2, t3} is a candidate edge. t4 must be
+    // on the same side of t3 as t1 of t2, otherwise the tour falls apart
+    if (isFixed(t1, t2)) {
+        return false;
+    }
+    const bool t2IsSuccessor = tour.successor(t1) == t2;
+    const signed_distance_t removedLength = tsplibProblem.dist(t1, t2);
+    for (const CandidateEdges::Edge &edge : candidateEdges[t2]) {
+        const vertex_t t3 = edge.vertex;
+        const signed_distance_t addedGain = removedLength - static_cast<signed_distance_t>(edge.distance);
+        if (addedGain <= 0 or t3 == t1) {
+            continue;
+        }
+        const vertex_t t4 = t2IsSuccessor ? tour.predecessor(t3) : tour.successor(t3);
+        if (t4 == t2 or isFixed(t3, t4)) {
+            continue;
+        }
+        const signed_distance_t gain = addedGain + static_cast<signed_distance_t>(tsplibProblem.dist(t3, t4)) -
+                                       static_cast<signed_distance_t>(tsplibProblem.dist(t4, t1));
+        if (gain > 0) {
+            STATISTICS_COUNT_AT_LEVEL(IMPROVING_MOVES, 2);
+            if (t2IsSuccessor) {
+                tour.flip(t2, t1, t4, t3);
+            } else {
+                tour.flip(t1, t2, t3, t4);
+            }
+            activate(t1);
+            activate(t2);
+            activate(t3);
+            activate(t4);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FastLocalSearch::improveByOrOpt(BaseTour &tour, vertex_t s1, bool forward) {
+    auto next = [&tour, forward](vertex_t v) { return forward ? tour.successor(v) : tour.predecessor(v); };
+    const vertex_t p = forward ? tour.predecessor(s1) : tour.successor(s1);
+    if (isFixed(p, s1)) {
+        return false;
+    }
+
+    // The segment is s1, ..., s2 followed by n
+    vertex_t s2 = s1;
+    for (std::size_t length = 1; length <= MAX_SEGMENT_LENGTH; ++length, s2 = next(s2)) {
+        const vertex_t n = next(s2);
+        if (n == p) {
+            // The segment contains all vertices except p
+            break;
+        }
+        // The gain of removing the segment and connecting p and n
+        const signed_distance_t removalGain = static_cast<signed_distance_t>(tsplibProblem.dist(p, s1)) +
+                                              static_cast<signed_distance_t>(tsplibProblem.dist(s2, n)) -
+                                              static_cast<signed_distance_t>(tsplibProblem.dist(p, n));
+        if (removalGain <= 0 or isFixed(s2, n)) {
+            continue;
+        }
+
+        // Insert the segment between c and d by adding the candidate edge {c, end}, where end is s1 or s2
+        for (vertex_t end : {s1, s2}) {
+            const vertex_t otherEnd = (end == s1) ? s2 : s1;
+            for (const CandidateEdges::Edge &edge : candidateEdges[end]) {
+                const vertex_t c = edge.vertex;
+                const signed_distance_t addedGain = removalGain - static_cast<signed_distance_t>(edge.distance);
+                if (addedGain <= 0) {
+                    continue;
+                }
+                // c and d may not be in the segment
+                bool cInSegment = (c == s2);
+                for (vertex_t v = s1; v != s2 and !cInSegment; v = next(v)) {
+                    cInSegment = (v == c);
+                }
+                if (cInSegment) {
+                    continue;
+                }
+                for (vertex_t d : tour.getNeighbors(c)) {
+                    if (d == s1 or d == s2 or (c == p and d == n) or (c == n and d == p) or isFixed(c, d)) {
+                        continue;
+                    }
+                    const signed_distance_t gain = addedGain +
+                                                   static_cast<signed_distance_t>(tsplibProblem.dist(c, d)) -
+                                                   static_cast<signed_distance_t>(tsplibProblem.dist(otherEnd, d));
+                    if (gain <= 0) {
+                        continue;
+                    }
+                    // Remove {d, c}, add {c, end}, remove the edges of the segment ends, add {p, n} and {otherEnd, d}
+                    AlternatingWalk closedWalk;
+                    closedWalk.push_back(d);
+                    closedWalk.push_back(c);
+                    closedWalk.push_back(end);
+                    closedWalk.push_back(end == s1 ? p : n);
+                    closedWalk.push_back(end == s1 ? n : p);
+                    closedWalk.push_back(otherEnd);
+                    closedWalk.push_back(d);
+                    if (tour.isTourAfterExchange(closedWalk)) {
+                        makeMove(tour, closedWalk);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void FastLocalSearch::improve(BaseTour &tour, const std::vector<vertex_t> &startVertices) {
+    STATISTICS_TIMER(LK_SEARCH);
+
+    isActive.assign(tour.getDimension(), false);
+    activeVertices.clear();
+    for (auto v = startVertices.rbegin(); v != startVertices.rend(); ++v) {
+        activate(*v);
+    }
+
+    while (!activeVertices.empty()) {
+        const vertex_t v = activeVertices.front();
+        activeVertices.pop_front();
+        isActive[v] = false;
+
+        // The don't-look bit of v is turned on again, unless a move changed one of its tour edges
+        improveByTwoOpt(tour, v, tour.successor(v)) or improveByTwoOpt(tour, v, tour.predecessor(v)) or
+        improveByOrOpt(tour, v, true) or improveByOrOpt(tour, v, false);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef LINKERNIGHANALGORITHM_FASTLOCALSEARCH_H
+#define LINKERNIGHANALGORITHM_FASTLOCALSEARCH_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================ FastLocalSearch class ==================================================
+
+// This class improves a tour with 2-opt moves and Or-opt moves (moving a segment of one to three vertices to another
+// place of the tour, possibly reversed). Only moves that add a candidate edge are tried and every vertex has a
+// don't-look bit: a vertex is only searched again, after one of its tour edges changed. The search stops when no
+// improving 2-opt or Or-opt move is found from any vertex whose don't-look bit is clear, so the result is a local
+// optimum for these moves restricted to the candidate edges, not for all 2-opt moves. It takes a fraction of the time
+// of improveTour and is used either as the whole search or to give improveTour a better start tour. Like improveTour,
+// it never removes a fixed edge from the tour.
+
+class FastLocalSearch {
+private:
+    // The maximum number of vertices in a segment moved by an Or-opt move
+    static const std::size_t MAX_SEGMENT_LENGTH = 3;
+
+    const TsplibProblem &tsplibProblem;
+    const CandidateEdges &candidateEdges;
+
+    // Returns whether the edge {v, w} is fixed, i.e. no move may remove it
+    const std::function<bool(vertex_t, vertex_t)> isFixed;
+
+    // The vertices whose don't-look bit is off, in the order in which they are searched
+    std::deque<vertex_t> activeVertices;
+
+    // isActive[v] is true if v is in activeVertices
+    std::vector<bool> isActive;
+
+    // Turn the don't-look bit of v off
+    void activate(vertex_t v);
+
+    // Tries an improving 2-opt move that removes the tour edge {t1, t2}, returns whether one was made
+    bool improveByTwoOpt(BaseTour &tour, vertex_t t1, vertex_t t2);
+
+    // Tries an improving Or-opt move that moves a segment starting at s1 in the successor direction if forward is true
+    // and in the predecessor direction otherwise, returns whether one was made
+    bool improveByOrOpt(BaseTour &tour, vertex_t s1, bool forward);
+
+    // Applies closedWalk to tour and turns the don't-look bits of all its vertices off
+    void makeMove(BaseTour &tour, const AlternatingWalk &closedWalk);
+
+public:
+    // The problem and the candidate edges must outlive this object, isFixed tells which edges may not be removed
+    FastLocalSearch(const TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                    std::function<bool(vertex_t, vertex_t)> isFixed = [](vertex_t, vertex_t) { return false; });
+
+    // Improve tour until no 2-opt or Or-opt move with a candidate edge improves it
+    // The vertices are searched in the order of startVertices from the back to the front first, like in improveTour
+    void improve(BaseTour &tour, const std::vector<vertex_t> &startVertices);
+};
+
+#endif //LINKERNIGHANALGORITHM_FASTLOCALSEARCH_H
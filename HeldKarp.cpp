@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "HeldKarp.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// =========================================== Held-Karp dynamic program ===============================================
+
+std::vector<vertex_t> shortestHamiltonianPath(const TsplibProblem &tsplibProblem,
+                                              const std::vector<vertex_t> &vertices) {
+    if (vertices.size() <= 3) {
+        // The path is unique
+        return vertices;
+    }
+
+    // The inner vertices are vertices[1], ..., vertices[m], the inner vertex u is vertices[u + 1]. Unreachable entries
+    // are infinite, which is small enough that adding a distance does not overflow
+    const std::size_t m = vertices.size() - 2;
+    const distance_t infinity = std::numeric_limits<distance_t>::max() / 4;
+    std::vector<distance_t> startDistances(m);
+    std::vector<distance_t> endDistances(m);
+    // distances[t * m + u] is the distance of the inner vertices u and t, so the distances to t are contiguous
+    std::vector<distance_t> distances(m * m);
+    for (std::size_t t = 0; t < m; ++t) {
+        startDistances[t] = tsplibProblem.dist(vertices.front(), vertices[t + 1]);
+        endDistances[t] = tsplibProblem.dist(vertices[t + 1], vertices.back());
+        for (std::size_t u = 0; u < m; ++u) {
+            distances[t * m + u] = tsplibProblem.dist(vertices[u + 1], vertices[t + 1]);
+        }
+    }
+
+    // table[mask * m + t] is the length of the shortest path from the start vertex through the inner vertices in mask
+    // that ends at the inner vertex t, or infinity if t is not in mask. The minimum over all u of a row is a loop
+    // without branches over contiguous memory, so the compiler can vectorize it
+    const std::size_t full = (std::size_t(1) << m) - 1;
+    std::vector<distance_t> table((full + 1) * m, infinity);
+    for (std::size_t t = 0; t < m; ++t) {
+        table[(std::size_t(1) << t) * m + t] = startDistances[t];
+    }
+    for (std::size_t mask = 1; mask <= full; ++mask) {
+        for (std::size_t t = 0; t < m; ++t) {
+            const std::size_t previousMask = mask ^ (std::size_t(1) << t);
+            if ((mask >> t & 1) == 0 or previousMask == 0) {
+                continue;
+            }
+            const distance_t *previousRow = &table[previousMask * m];
+            const distance_t *distancesToT = &distances[t * m];
+            distance_t shortest = infinity;
+            for (std::size_t u = 0; u < m; ++u) {
+                shortest = std::min(shortest, previousRow[u] + distancesToT[u]);
+            }
+            table[mask * m + t] = shortest;
+        }
+    }
+
+    // Find the last inner vertex and follow the shortest paths back to the start vertex
+    std::size_t last = 0;
+    for (std::size_t t = 1; t < m; ++t) {
+        if (table[full * m + t] + endDistances[t] < table[full * m + last] + endDistances[last]) {
+            last = t;
+        }
+    }
+    std::vector<vertex_t> path(vertices.size());
+    path.front() = vertices.front();
+    path.back() = vertices.back();
+    std::size_t mask = full;
+    std::size_t t = last;
+    for (std::size_t position = m; position > 0; --position) {
+        path[position] = vertices[t + 1];
+        const std::size_t previousMask = mask ^ (std::size_t(1) << t);
+        for (std::size_t u = 0; u < m and previousMask != 0; ++u) {
+            if (table[previousMask * m + u] + distances[t * m + u] == table[mask * m + t]) {
+                t = u;
+                break;
+            }
+        }
+        mask = previousMask;
+    }
+    return path;
+}
+
+Tour solveExactly(const TsplibProblem &tsplibProblem, dimension_t groupSize) {
+    // A tour is a shortest path from vertex 0 back to vertex 0 through all other vertices
+    const dimension_t dimension = tsplibProblem.getDimension();
+    std::vector<vertex_t> vertices(dimension + 1, 0);
+    for (vertex_t v = 1; v < dimension; ++v) {
+        vertices[v] = v;
+    }
+    std::vector<vertex_t> tourSequence = shortestHamiltonianPath(tsplibProblem, vertices);
+    tourSequence.pop_back();
+
+    Tour tour;
+    tour.setVertices(tourSequence, groupSize);
+    return tour;
+}
+
+Tour optimizeWindows(const TsplibProblem &tsplibProblem, const Tour &tour, std::size_t windowSize,
+                     dimension_t groupSize) {
+    const dimension_t dimension = tsplibProblem.getDimension();
+    if (dimension <= windowSize) {
+        return tour;
+    }
+
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(dimension);
+    vertex_t v = 0;
+    do {
+        tourSequence.push_back(v);
+        v = tour.successor(v);
+    } while (v != 0);
+
+    // Returns the length of the path through the vertices of window
+    auto pathLength = [&tsplibProblem](const std::vector<vertex_t> &window) {
+        distance_t length = 0;
+        for (std::size_t i = 0; i + 1 < window.size(); ++i) {
+            length += tsplibProblem.dist(window[i], window[i + 1]);
+        }
+        return length;
+    };
+
+    const std::size_t step = windowSize / 2;
+    std::vector<vertex_t> window(windowSize);
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (std::size_t start = 0; start < dimension; start += step) {
+            for (std::size_t i = 0; i < windowSize; ++i) {
+                window[i] = tourSequence[(start + i) % dimension];
+            }
+            const std::vector<vertex_t> path = shortestHamiltonianPath(tsplibProblem, window);
+            if (pathLength(path) < pathLength(window)) {
+                for (std::size_t i = 0; i < windowSize; ++i) {
+                    tourSequence[(start + i) % dimension] = path[i];
+                }
+                improved = true;
+            }
+        }
+    }
+
+    Tour optimizedTour;
+    optimizedTour.setVertices(tourSequence, groupSize);
+    return optimizedTour;
+}
@@ -0,0 +1,38 @@
+#ifndef LINKERNIGHANALGORITHM_HELDKARP_H
+#define LINKERNIGHANALGORITHM_HELDKARP_H
+
+#include <cstddef>
+#include <vector>
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// =========================================== Held-Karp dynamic program ===============================================
+
+// The dynamic program of Held and Karp finds a shortest path from a start vertex to an end vertex through m other
+// vertices in O(2^m * m^2) time and with O(2^m * m) memory, so it is only usable for very few vertices.
+
+// The maximum number of vertices of a problem that solveExactly solves (2^15 * 15 table entries)
+const dimension_t MAX_EXACT_DIMENSION = 16;
+
+// The maximum windowSize of optimizeWindows (2^16 * 16 table entries)
+const std::size_t MAX_WINDOW_SIZE = 18;
+
+// Returns vertices in the order of a shortest path from vertices.front() to vertices.back() that visits all of them
+// Expects 2 <= vertices.size() <= MAX_WINDOW_SIZE, the first and the last vertex may be the same vertex
+std::vector<vertex_t> shortestHamiltonianPath(const TsplibProblem &tsplibProblem,
+                                              const std::vector<vertex_t> &vertices);
+
+// Returns an optimum tour of the problem, groupSize is the groupSize of the tour (see TwoLevelTreeTour), 0 means the
+// default
+// Expects tsplibProblem.getDimension() <= MAX_EXACT_DIMENSION
+Tour solveExactly(const TsplibProblem &tsplibProblem, dimension_t groupSize = 0);
+
+// Slides a window of windowSize consecutive vertices over tour and replaces the path through every window by the
+// shortest path between the same two end vertices (see shortestHamiltonianPath). The windows of a pass overlap by half,
+// the passes are repeated until no window improves the tour. The result is never longer than tour. groupSize is the
+// same as for solveExactly
+// Expects 4 <= windowSize <= MAX_WINDOW_SIZE
+Tour optimizeWindows(const TsplibProblem &tsplibProblem, const Tour &tour, std::size_t windowSize,
+                     dimension_t groupSize = 0);
+
+#endif //LINKERNIGHANALGORITHM_HELDKARP_H
@@ -3,7 +3,9 @@
 //
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <numeric>
@@ -17,44 +19,94 @@
 #include "TsplibUtils.h"
 #include "LinKernighanHeuristic.h"
 #include "AlphaDistances.h"
+#include "FastLocalSearch.h"
+#include "Statistics.h"
+#include "TourMerging.h"
 
 // ============================================= CandidateEdges class =================================================
 
-CandidateEdges::CandidateEdges(dimension_t dimension, const std::vector<vertex_t> &fillValue) : neighbors(dimension,
-                                                                                                          fillValue) {}
+CandidateEdges::Range::Range(const Edge *first, const Edge *last) : first(first), last(last) {}
 
-std::vector<vertex_t> &CandidateEdges::operator[](std::size_t index) {
-    return neighbors[index];
+const CandidateEdges::Edge *CandidateEdges::Range::begin() const {
+    return first;
 }
 
-CandidateEdges CandidateEdges::allNeighbors(const TsplibProblem &problem) {
-    std::vector<vertex_t> allVertices(problem.getDimension());
-    std::iota(allVertices.begin(), allVertices.end(), 0);
+const CandidateEdges::Edge *CandidateEdges::Range::end() const {
+    return last;
+}
+
+std::size_t CandidateEdges::Range::size() const {
+    return static_cast<std::size_t>(last - first);
+}
+
+void CandidateEdges::addEdge(vertex_t w, distance_t distance) {
+    edges.push_back(Edge{w, distance});
+}
+
+void CandidateEdges::finishVertex() {
+    offsets.push_back(edges.size());
+}
+
+CandidateEdges::CandidateEdges(const TsplibProblem &problem, const std::vector<std::vector<vertex_t>> &neighbors) {
+    offsets.reserve(neighbors.size() + 1);
+    for (vertex_t v = 0; v < neighbors.size(); ++v) {
+        for (vertex_t w : neighbors[v]) {
+            addEdge(w, problem.dist(v, w));
+        }
+        finishVertex();
+    }
+}
+
+dimension_t CandidateEdges::getDimension() const {
+    return offsets.size() - 1;
+}
+
+CandidateEdges::Range CandidateEdges::operator[](vertex_t v) const {
+    return Range(edges.data() + offsets[v], edges.data() + offsets[v + 1]);
+}
 
-    CandidateEdges result(problem.getDimension(), allVertices);
-    for (vertex_t v : allVertices) {
-        // Delete v from its neighbors
-        result[v].erase(std::remove(result[v].begin(), result[v].end(), v), result[v].end());
+CandidateEdges CandidateEdges::allNeighbors(const TsplibProblem &problem) {
+    const dimension_t dimension = problem.getDimension();
+    CandidateEdges result;
+    result.offsets.reserve(dimension + 1);
+    result.edges.reserve(dimension * (dimension - 1));
+    for (vertex_t v = 0; v < dimension; ++v) {
+        for (vertex_t w = 0; w < dimension; ++w) {
+            if (w != v) {
+                result.addEdge(w, problem.dist(v, w));
+            }
+        }
+        result.finishVertex();
     }
     return result;
 }
 
-CandidateEdges CandidateEdges::rawNearestNeighbors(
-        dimension_t dimension, std::size_t k, const std::function<bool(vertex_t, vertex_t, vertex_t)> &distCompare) {
+CandidateEdges CandidateEdges::rawNearestNeighbors(const TsplibProblem &problem, std::size_t k,
+                                                   const std::function<bool(vertex_t, vertex_t, vertex_t)> &distCompare) {
+    const dimension_t dimension = problem.getDimension();
     std::unordered_set<vertex_t> allVertices{};
     for (vertex_t v = 0; v < dimension; ++v) {
         allVertices.insert(v);
     }
 
-    CandidateEdges result(dimension, std::vector<vertex_t>(k));
+    STATISTICS_TIMER(CANDIDATE_SORTING);
+    CandidateEdges result;
+    result.offsets.reserve(dimension + 1);
+    result.edges.reserve(dimension * k);
+    std::vector<vertex_t> nearest(k);
     for (vertex_t v = 0; v < dimension; ++v) {
-        // Sort the k nearest neighbors of v by distance to v and put them in result[v]
+        // Sort the k nearest neighbors of v by distance to v and append them to result
         allVertices.erase(v); // Don't include v in the search
         // std::bind(distCompare, v, std::placeholders::_1, std::placeholders::_2) is a function that takes two vertices
         // and compares them by their distance to v
-        std::partial_sort_copy(allVertices.begin(), allVertices.end(), result[v].begin(), result[v].end(),
-                               std::bind(distCompare, v, std::placeholders::_1, std::placeholders::_2));
+        auto nearestEnd = std::partial_sort_copy(allVertices.begin(), allVertices.end(), nearest.begin(), nearest.end(),
+                                                 std::bind(distCompare, v, std::placeholders::_1,
+                                                           std::placeholders::_2));
         allVertices.insert(v);
+        for (auto w = nearest.begin(); w != nearestEnd; ++w) {
+            result.addEdge(*w, problem.dist(v, *w));
+        }
+        result.finishVertex();
     }
     return result;
 }
@@ -64,12 +116,32 @@ CandidateEdges CandidateEdges::nearestNeighbors(const TsplibProblem &problem, st
         return problem.dist(v, w1) < problem.dist(v, w2);
     };
 
-    return rawNearestNeighbors(problem.getDimension(), k, distCompare);
+    return rawNearestNeighbors(problem, k, distCompare);
 }
 
-CandidateEdges CandidateEdges::alphaNearestNeighbors(const TsplibProblem &problem, std::size_t k) {
+CandidateEdges CandidateEdges::sparseNearestNeighbors(const TsplibProblem &problem, std::size_t k) {
+    const std::vector<std::vector<vertex_t>> neighbors = problem.gridNearestNeighbors(k);
+    if (neighbors.empty()) {
+        return nearestNeighbors(problem, k);
+    }
+    return CandidateEdges(problem, neighbors);
+}
+
+CandidateEdges CandidateEdges::alphaNearestNeighbors(const TsplibProblem &problem, std::size_t k,
+                                                     bool streamingAlpha) {
     auto dist = [&problem](vertex_t i, vertex_t j) { return problem.dist(i, j); };
 
+    if (streamingAlpha) {
+        StreamingAlphaDistances alpha(problem.getDimension(), dist);
+
+        // rawNearestNeighbors compares the neighbors of one vertex after another, so every row is computed only once
+        auto distCompare = [&problem, &alpha](vertex_t v, vertex_t w1, vertex_t w2) {
+            return std::make_tuple(alpha(v, w1), problem.dist(v, w1)) <
+                   std::make_tuple(alpha(v, w2), problem.dist(v, w2));
+        };
+        return rawNearestNeighbors(problem, k, distCompare);
+    }
+
     // Compute the alpha distances
     std::vector<std::vector<distance_t>> alpha = alphaDistances(problem.getDimension(), dist);
 
@@ -77,12 +149,26 @@ CandidateEdges CandidateEdges::alphaNearestNeighbors(const TsplibProblem &proble
         return std::make_tuple(alpha[v][w1], problem.dist(v, w1)) <
                std::make_tuple(alpha[v][w2], problem.dist(v, w2));
     };
-    return rawNearestNeighbors(problem.getDimension(), k, distCompare);
+    return rawNearestNeighbors(problem, k, distCompare);
 }
 
-CandidateEdges CandidateEdges::optimizedAlphaNearestNeighbors(const TsplibProblem &problem, std::size_t k) {
+CandidateEdges CandidateEdges::optimizedAlphaNearestNeighbors(const TsplibProblem &problem, std::size_t k,
+                                                              bool streamingAlpha) {
     auto dist = [&problem](vertex_t i, vertex_t j) { return problem.dist(i, j); };
 
+    if (streamingAlpha) {
+        std::vector<signed_distance_t> penalties = subgradientPenalties(problem.getDimension(), dist);
+        StreamingAlphaDistances alpha(problem.getDimension(), [&dist, &penalties](vertex_t v, vertex_t w) {
+            return dist(v, w) + penalties[v] + penalties[w];
+        });
+
+        auto distCompare = [&problem, &alpha](vertex_t v, vertex_t w1, vertex_t w2) {
+            return std::make_tuple(alpha(v, w1), problem.dist(v, w1)) <
+                   std::make_tuple(alpha(v, w2), problem.dist(v, w2));
+        };
+        return rawNearestNeighbors(problem, k, distCompare);
+    }
+
     // Compute the optimized alpha distances
     std::vector<std::vector<distance_t>> alpha = optimizedAlphaDistances(problem.getDimension(), dist);
 
@@ -90,38 +176,118 @@ CandidateEdges CandidateEdges::optimizedAlphaNearestNeighbors(const TsplibProble
         return std::make_tuple(alpha[v][w1], problem.dist(v, w1)) <
                std::make_tuple(alpha[v][w2], problem.dist(v, w2));
     };
-    return rawNearestNeighbors(problem.getDimension(), k, distCompare);
+    return rawNearestNeighbors(problem, k, distCompare);
 }
 
 CandidateEdges CandidateEdges::create(const TsplibProblem &problem, CandidateEdges::Type candidateEdgeType,
-                                      std::size_t k) {
+                                      std::size_t k, bool streamingAlpha) {
     switch (candidateEdgeType) {
         case Type::ALL_NEIGHBORS:
             return CandidateEdges::allNeighbors(problem);
         case Type::NEAREST_NEIGHBORS:
             return CandidateEdges::nearestNeighbors(problem, k);
         case Type::ALPHA_NEAREST_NEIGHBORS:
-            return CandidateEdges::alphaNearestNeighbors(problem, k);
+            return CandidateEdges::alphaNearestNeighbors(problem, k, streamingAlpha);
         default:
         case Type::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS:
-            return CandidateEdges::optimizedAlphaNearestNeighbors(problem, k);
+            return CandidateEdges::optimizedAlphaNearestNeighbors(problem, k, streamingAlpha);
     }
 }
 
 
 // ========================================== LinKernighanHeuristic class ==============================================
 
-LinKernighanHeuristic::LinKernighanHeuristic(TsplibProblem &tsplibProblem, CandidateEdges candidateEdges)
-        : tsplibProblem(tsplibProblem), candidateEdges(std::move(candidateEdges)) {
+LinKernighanHeuristic::LinKernighanHeuristic(TsplibProblem &tsplibProblem, CandidateEdges candidateEdges,
+                                             std::mt19937::result_type seed, Parameters parameters)
+        : tsplibProblem(tsplibProblem), candidateEdges(std::move(candidateEdges)), parameters(std::move(parameters)),
+          randomNumberGenerator(seed) {
+    // The distances of the candidate edges are needed most often, so they are always kept if distances are cached
+    std::vector<std::vector<vertex_t>> neighbors(tsplibProblem.getDimension());
+    for (vertex_t v = 0; v < neighbors.size(); ++v) {
+        for (const CandidateEdges::Edge &edge : this->candidateEdges[v]) {
+            neighbors[v].push_back(edge.vertex);
+        }
+    }
+    this->tsplibProblem.cacheNeighborDistances(neighbors);
+
+    startVertices.resize(tsplibProblem.getDimension());
+    std::iota(startVertices.begin(), startVertices.end(), 0);
+    std::sort(startVertices.begin(), startVertices.end(), [&tsplibProblem](vertex_t v, vertex_t w) {
+        return tsplibProblem.getOriginalVertex(v) < tsplibProblem.getOriginalVertex(w);
+    });
 }
 
 vertex_t LinKernighanHeuristic::chooseRandomElement(const std::vector<vertex_t> &elements) {
-    std::random_device randomNumberGenerator;
     std::uniform_int_distribution<std::size_t> distribution(0, elements.size() - 1);
     return elements[distribution(randomNumberGenerator)];
 }
 
+std::size_t LinKernighanHeuristic::edgeFrequency(vertex_t v, vertex_t w) const {
+    if (recentTours.empty()) {
+        return currentBestTour.getDimension() != 0 and currentBestTour.containsEdge(v, w) ? 1 : 0;
+    }
+    return static_cast<std::size_t>(std::count_if(recentTours.begin(), recentTours.end(),
+                                                  [v, w](const TourSnapshot &tour) {
+                                                      return tour.containsEdge(v, w);
+                                                  }));
+}
+
+bool LinKernighanHeuristic::isFixed(vertex_t v, vertex_t w) const {
+    return !fixedNeighbors.empty() and (fixedNeighbors[2 * v] == w or fixedNeighbors[2 * v + 1] == w);
+}
+
+void LinKernighanHeuristic::updateBackbone(const Tour &tour) {
+    // A tour that is already stored is not added again. Otherwise a few trials that return the same tour would make all
+    // its edges contained in all recent tours, the whole tour would be fixed and every further trial could only return
+    // this tour again. A repeated tour also releases the fixed backbone until the next distinct tour, it led the trial
+    // back to a known tour
+    for (const TourSnapshot &recentTour : recentTours) {
+        if (recentTour.getHash() == tour.getHash()) {
+            if (parameters.fixBackbone) {
+                fixedNeighbors = permanentlyFixedNeighbors;
+            }
+            return;
+        }
+    }
+
+    // The snapshot of the oldest tour is reused for the new one
+    if (recentTours.size() == parameters.backboneSize) {
+        recentTours.push_back(std::move(recentTours.front()));
+        recentTours.pop_front();
+    } else {
+        recentTours.emplace_back();
+    }
+    recentTours.back().copyFrom(tour);
+    if (!parameters.fixBackbone or recentTours.size() < std::max<std::size_t>(parameters.backboneSize, 2)) {
+        return;
+    }
+
+    // The fixed edges are the edges of the oldest tour that all other tours contain as well. The tours are distinct, so
+    // at least one edge of every tour is not fixed. The edges fixed by fixEdge are kept, a tour found before the call
+    // to fixEdge may lack them, so a backbone edge is only added where a vertex has a free place left
+    const dimension_t dimension = tsplibProblem.getDimension();
+    fixedNeighbors = permanentlyFixedNeighbors;
+    if (fixedNeighbors.empty()) {
+        fixedNeighbors.assign(2 * dimension, dimension);
+    }
+    for (vertex_t v = 0; v < dimension; ++v) {
+        const vertex_t neighbors[] = {recentTours.front().predecessor(v), recentTours.front().successor(v)};
+        for (vertex_t w : neighbors) {
+            if (edgeFrequency(v, w) == recentTours.size() and !isFixed(v, w)) {
+                for (std::size_t j = 0; j < 2; ++j) {
+                    if (fixedNeighbors[2 * v + j] == dimension) {
+                        fixedNeighbors[2 * v + j] = w;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
 Tour LinKernighanHeuristic::generateRandomTour() {
+    STATISTICS_TIMER(TOUR_CONSTRUCTION);
+
     // Initialize a array with all vertices as the remaining vertices (that are to be placed on the tour)
     std::vector<vertex_t> remainingVertices(tsplibProblem.getDimension());
     std::iota(remainingVertices.begin(), remainingVertices.end(), 0);
@@ -135,30 +301,54 @@ Tour LinKernighanHeuristic::generateRandomTour() {
     tourSequence.push_back(currentVertex);
 
     // In each step, decide for each vertex otherVertex if it is an element in one or more of these categories
-    // (1) otherVertex was not already chosen and {currentVertex, otherVertex} is a candidate edge and on the
-    //     current best tour
+    // (0) otherVertex was not already chosen and {currentVertex, otherVertex} is fixed
+    // (1) otherVertex was not already chosen and {currentVertex, otherVertex} is a candidate edge with the highest
+    //     positive frequency in the recent tours (see edgeFrequency), without recent tours these are the candidate
+    //     edges on the current best tour
     // (2) otherVertex was not already chosen and {currentVertex, otherVertex} is a candidate edge
     // (3) otherVertex was not already chosen
     // Choose the next current vertex randomly from the first non-empty category above
 
-    std::vector<vertex_t> candidatesInBestTour; // Category (1)
+    const dimension_t dimension = tsplibProblem.getDimension();
+    std::vector<vertex_t> frequentCandidates; // Category (1)
     std::vector<vertex_t> candidates; // Category (2)
     // Category (3) is remainingVertices
+    auto isRemaining = [&remainingVertices](vertex_t v) {
+        return std::find(remainingVertices.begin(), remainingVertices.end(), v) != remainingVertices.end();
+    };
     while (!remainingVertices.empty()) {
-        candidatesInBestTour.clear();
+        vertex_t fixedNeighbor = dimension; // Category (0), it has at most one element
+        if (!fixedNeighbors.empty()) {
+            for (std::size_t j = 0; j < 2; ++j) {
+                if (fixedNeighbors[2 * currentVertex + j] != dimension and
+                    isRemaining(fixedNeighbors[2 * currentVertex + j])) {
+                    fixedNeighbor = fixedNeighbors[2 * currentVertex + j];
+                }
+            }
+        }
+
+        frequentCandidates.clear();
         candidates.clear();
-        for (vertex_t otherVertex : candidateEdges[currentVertex]) {
-            if (std::find(remainingVertices.begin(), remainingVertices.end(), otherVertex) != remainingVertices.end()) {
-                // otherVertex is an element of remainingVertices
-                if (currentBestTour.getDimension() != 0 and currentBestTour.containsEdge(currentVertex, otherVertex)) {
-                    candidatesInBestTour.push_back(otherVertex);
+        std::size_t highestFrequency = 0;
+        for (const CandidateEdges::Edge &edge : candidateEdges[currentVertex]) {
+            const vertex_t otherVertex = edge.vertex;
+            if (isRemaining(otherVertex)) {
+                const std::size_t frequency = edgeFrequency(currentVertex, otherVertex);
+                if (frequency > highestFrequency) {
+                    frequentCandidates.clear();
+                    highestFrequency = frequency;
+                }
+                if (frequency > 0 and frequency == highestFrequency) {
+                    frequentCandidates.push_back(otherVertex);
                 }
                 candidates.push_back(otherVertex);
             }
         }
 
-        if (!candidatesInBestTour.empty()) {
-            currentVertex = chooseRandomElement(candidatesInBestTour);
+        if (fixedNeighbor != dimension) {
+            currentVertex = fixedNeighbor;
+        } else if (!frequentCandidates.empty()) {
+            currentVertex = chooseRandomElement(frequentCandidates);
         } else if (!candidates.empty()) {
             currentVertex = chooseRandomElement(candidates);
         } else {
@@ -169,20 +359,41 @@ Tour LinKernighanHeuristic::generateRandomTour() {
         tourSequence.push_back(currentVertex);
     }
 
-    return Tour(tourSequence);
+    return createTour(tourSequence);
 }
 
-Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
-    const dimension_t dimension = tsplibProblem.getDimension();
+template<LinKernighanHeuristic::CandidateOrder candidateOrder, bool limitedSearch>
+void LinKernighanHeuristic::improveTour(Tour &currentTour) {
+    STATISTICS_TIMER(LK_SEARCH);
+
+    const std::size_t backtrackingDepth = parameters.backtrackingDepth;
+    const std::size_t infeasibilityDepth = parameters.infeasibilityDepth;
 
-    Tour currentTour = startTour;
     // vertexChoices[i] stores all possible choices for vertex x_i. This is used for backtracking
     std::vector<std::vector<vertex_t>> vertexChoices;
     AlternatingWalk currentWalk; // The i-th element of currentWalk is also referred to as x_i
     AlternatingWalk bestAlternatingWalk;
     signed_distance_t highestGain = 0;
+    // The possible in-edges (x_i, x) with the value they are ordered by, see CandidateOrder
+    std::vector<std::pair<signed_distance_t, vertex_t>> rankedChoices;
+    // With don't-look bits only the active vertices are tried as x_0, see Parameters::dontLookBits
+    const bool dontLookBits = parameters.dontLookBits;
+    std::vector<vertex_t> activeVertices;
+    std::vector<bool> isActive;
+    if (dontLookBits) {
+        activeVertices = startVertices;
+        isActive.assign(tsplibProblem.getDimension(), false);
+        for (vertex_t v : activeVertices) {
+            isActive[v] = true;
+        }
+    }
 
     while (true) {
+        // The search from a known local optimum would only find it again, so it is abandoned
+        if (knownOptima.count(currentTour.getHash()) != 0) {
+            return;
+        }
+
         // Reset everything
         vertexChoices.clear();
         currentWalk.clear();
@@ -190,22 +401,38 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
         highestGain = 0;
         std::size_t i = 0;
 
-        // Fill vertexChoices[0] with all vertices
-        vertexChoices.emplace_back(dimension);
-        std::iota(vertexChoices[0].begin(), vertexChoices[0].end(), 0);
+        // Fill vertexChoices[0] with all vertices or the active ones
+        if (dontLookBits) {
+            vertexChoices.emplace_back();
+            vertexChoices[0].swap(activeVertices);
+        } else {
+            vertexChoices.push_back(startVertices);
+        }
 
         while (true) {
             if (vertexChoices[i].empty()) {
                 // The current alternating walk cannot be expanded further
                 if (highestGain > 0) {
+                    STATISTICS_COUNT_AT_LEVEL(IMPROVING_MOVES, bestAlternatingWalk.size() / 2);
                     currentTour.exchange(bestAlternatingWalk);
+                    if (dontLookBits) {
+                        // The untried vertices stay active and the vertices of changed edges are activated
+                        activeVertices.swap(vertexChoices[0]);
+                        for (vertex_t v : bestAlternatingWalk) {
+                            if (!isActive[v]) {
+                                isActive[v] = true;
+                                activeVertices.push_back(v);
+                            }
+                        }
+                    }
                     break;
                 } else { // highestGain == 0
                     if (i == 0) {
                         // No improvement for currentTour was found
-                        return currentTour;
+                        return;
                     } else {
                         // Reset the search to level min(i-1, backtrackingDepth)
+                        STATISTICS_COUNT_AT_LEVEL(BACKTRACKS, i);
                         i = std::min(i - 1, backtrackingDepth);
                         vertexChoices.erase(vertexChoices.begin() + i + 1, vertexChoices.end());
                         currentWalk.erase(currentWalk.begin() + i, currentWalk.end());
@@ -217,6 +444,9 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
             // Choose x_i from vertexChoices[i] and remove it from there
             vertex_t xi = vertexChoices[i].back();
             vertexChoices[i].pop_back();
+            if (dontLookBits and i == 0) {
+                isActive[xi] = false;
+            }
             currentWalk.push_back(xi);
 
             if (i % 2 == 1 and i >= 3) {
@@ -233,17 +463,62 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
             // Add vertexChoices[i+1] and fill it afterwards
             vertexChoices.emplace_back();
             if (i % 2 == 1) { // i is odd
+                if (limitedSearch and parameters.maxMoveDepth != 0 and (i + 1) / 2 >= parameters.maxMoveDepth) {
+                    // Closing the walk after another in-edge would exchange more than maxMoveDepth edges
+                    ++i;
+                    continue;
+                }
+
                 // Determine possible in-edges (xi, x)
                 signed_distance_t currentGain = tsplibProblem.exchangeGain(currentWalk);
                 vertex_t xiPredecessor = currentTour.predecessor(xi);
                 vertex_t xiSuccessor = currentTour.successor(xi);
-                for (vertex_t x : candidateEdges[xi]) {
+                rankedChoices.clear();
+                for (const CandidateEdges::Edge &edge : candidateEdges[xi]) {
+                    const vertex_t x = edge.vertex;
                     if (x != currentWalk[0]
                         and x != xiPredecessor and x != xiSuccessor // equivalent to !currentTour.containsEdge(xi, x)
                         and !currentWalk.containsEdge(xi, x)
-                        and currentGain - static_cast<signed_distance_t>(tsplibProblem.dist(xi, x)) > highestGain) {
+                        and currentGain - static_cast<signed_distance_t>(edge.distance) > highestGain) {
+
+                        // The choices are ranked such that the best one has the lowest rank, the gain g is the same for
+                        // all choices and does not change the order
+                        signed_distance_t rank = 0;
+                        if (candidateOrder == LOOKAHEAD_ORDER) {
+                            distance_t nextOutEdge = std::max(tsplibProblem.dist(x, currentTour.predecessor(x)),
+                                                              tsplibProblem.dist(x, currentTour.successor(x)));
+                            rank = static_cast<signed_distance_t>(edge.distance) -
+                                   static_cast<signed_distance_t>(nextOutEdge);
+                        }
+                        rankedChoices.emplace_back(rank, x);
+                    }
+                }
 
-                        vertexChoices[i + 1].push_back(x);
+                // The candidate edges are in alpha order, the stable sort keeps it among choices with the same rank
+                if (candidateOrder == LOOKAHEAD_ORDER) {
+                    std::stable_sort(rankedChoices.begin(), rankedChoices.end(),
+                                     [](const std::pair<signed_distance_t, vertex_t> &choice1,
+                                        const std::pair<signed_distance_t, vertex_t> &choice2) {
+                                         return choice1.first < choice2.first;
+                                     });
+                }
+                const std::vector<std::size_t> &breadth = parameters.breadth;
+                if (limitedSearch and !breadth.empty()) {
+                    const std::size_t maxChoices = breadth[std::min(i / 2, breadth.size() - 1)];
+                    if (rankedChoices.size() > maxChoices) {
+                        rankedChoices.resize(maxChoices);
+                    }
+                }
+
+                // The choices are taken from the back, so they are inserted from the worst to the best, or from the
+                // best to the worst for the reverse order
+                if (candidateOrder == REVERSE_ALPHA_ORDER) {
+                    for (const std::pair<signed_distance_t, vertex_t> &choice : rankedChoices) {
+                        vertexChoices[i + 1].push_back(choice.second);
+                    }
+                } else {
+                    for (auto choice = rankedChoices.rbegin(); choice != rankedChoices.rend(); ++choice) {
+                        vertexChoices[i + 1].push_back(choice->second);
                     }
                 }
             } else { // i is even
@@ -262,14 +537,15 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
                     // The first edge to be broken may not be on the currently best solution tour
                     // (1) can not happen because x_0 is not a neighbor of x_0
                     for (vertex_t neighbor : currentTour.getNeighbors(xi)) {
-                        if (!currentBestTour.containsEdge(xi, neighbor)) {
+                        if (!currentBestTour.containsEdge(xi, neighbor) and !isFixed(xi, neighbor)) {
                             vertexChoices[i + 1].push_back(neighbor);
                         }
                     }
                 } else if (i <= infeasibilityDepth) {
                     for (vertex_t neighbor : currentTour.getNeighbors(xi)) {
                         if (neighbor != currentWalk[0] // (1)
-                            and !currentWalk.containsEdge(xi, neighbor)) {
+                            and !currentWalk.containsEdge(xi, neighbor)
+                            and !isFixed(xi, neighbor)) {
 
                             vertexChoices[i + 1].push_back(neighbor);
                         }
@@ -279,6 +555,7 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
                         if (neighbor != currentWalk[0] // (1)
                             and !currentWalk.containsEdge(xi, neighbor)
                             and neighbor != currentWalk[1] // (2)
+                            and !isFixed(xi, neighbor)
                             and currentTour.isTourAfterExchange(currentWalk.appendAndClose(neighbor))) {
 
                             vertexChoices[i + 1].push_back(neighbor);
@@ -293,6 +570,211 @@ Tour LinKernighanHeuristic::improveTour(const Tour &startTour) {
     }
 }
 
+bool LinKernighanHeuristic::searchFiveOptStep(const Tour &tour, AlternatingWalk &walk,
+                                              const AlternatingWalk &previousSteps, signed_distance_t gain,
+                                              std::size_t remainingEdges, FiveOptStep &bestStep,
+                                              AlternatingWalk &improvingWalk) {
+    const vertex_t first = walk[0];
+    const vertex_t last = walk[walk.size() - 1];
+    for (const CandidateEdges::Edge &edge : candidateEdges[last]) {
+        // Add the edge (last, x), it may not be on the tour or the walk and the gain must stay positive
+        const vertex_t x = edge.vertex;
+        const signed_distance_t addedGain = gain - static_cast<signed_distance_t>(edge.distance);
+        if (addedGain <= 0 or x == first or tour.containsEdge(last, x) or walk.containsEdge(last, x) or
+            previousSteps.containsEdge(last, x)) {
+            continue;
+        }
+
+        const vertex_t xNeighbors[] = {tour.predecessor(x), tour.successor(x)};
+        for (vertex_t y : xNeighbors) {
+            // Remove the edge (x, y), the closing edge (y, first) may not be the removed edge (first, walk[1])
+            if (y == first or y == walk[1] or walk.containsEdge(x, y) or previousSteps.containsEdge(x, y) or
+                isFixed(x, y)) {
+                continue;
+            }
+            walk.push_back(x);
+            walk.push_back(y);
+            const signed_distance_t removedGain = addedGain + static_cast<signed_distance_t>(tsplibProblem.dist(x, y));
+            const bool canClose = !tour.containsEdge(y, first);
+            const signed_distance_t closedGain =
+                    removedGain - static_cast<signed_distance_t>(tsplibProblem.dist(y, first));
+
+            if (canClose and closedGain > 0) {
+                AlternatingWalk closedWalk = walk.close();
+                if (tour.isTourAfterExchange(closedWalk)) {
+                    improvingWalk = closedWalk;
+                    return true;
+                }
+            }
+            if (remainingEdges > 1) {
+                if (searchFiveOptStep(tour, walk, previousSteps, removedGain, remainingEdges - 1, bestStep,
+                                      improvingWalk)) {
+                    return true;
+                }
+            } else if (canClose and removedGain > bestStep.gain and tour.isTourAfterExchange(walk.close())) {
+                bestStep.walk = walk;
+                bestStep.gain = removedGain;
+            }
+            walk.erase(walk.end() - 2, walk.end());
+        }
+    }
+    return false;
+}
+
+bool LinKernighanHeuristic::applyFiveOptMove(Tour &tour, vertex_t t1, AlternatingWalk &improvingWalk) {
+    // The walk of the current step on the tour after the tentative steps, and all steps as one walk on the tour before
+    // them. The latter keeps the edges that the steps exchanged, no later step may exchange them again
+    AlternatingWalk walk;
+    AlternatingWalk allSteps;
+    for (vertex_t t2 : tour.getNeighbors(t1)) {
+        // The first edge to be broken may not be on the currently best solution tour or fixed
+        if ((currentBestTour.getDimension() != 0 and currentBestTour.containsEdge(t1, t2)) or isFixed(t1, t2)) {
+            continue;
+        }
+        walk.clear();
+        walk.push_back(t1);
+        walk.push_back(t2);
+        allSteps = walk;
+        signed_distance_t gain = tsplibProblem.dist(t1, t2);
+        tour.setCheckpoint();
+
+        // The first step removes the edge (t1, t2) and four more edges, every following step continues the walk with
+        // four more edges
+        while (parameters.maxMoveDepth == 0 or allSteps.size() / 2 < parameters.maxMoveDepth) {
+            std::size_t remainingEdges = 4;
+            if (parameters.maxMoveDepth != 0) {
+                remainingEdges = std::min(remainingEdges, parameters.maxMoveDepth - allSteps.size() / 2);
+            }
+            FiveOptStep bestStep{AlternatingWalk(), 0};
+            if (searchFiveOptStep(tour, walk, allSteps, gain, remainingEdges, bestStep, improvingWalk)) {
+                tour.exchange(improvingWalk);
+                tour.discardCheckpoint();
+                for (auto v = improvingWalk.begin() + 2; v != improvingWalk.end() - 1; ++v) {
+                    allSteps.push_back(*v);
+                }
+                improvingWalk = allSteps.close();
+                STATISTICS_COUNT_AT_LEVEL(IMPROVING_MOVES, improvingWalk.size() / 2);
+                return true;
+            }
+            if (bestStep.walk.size() == 0) {
+                break;
+            }
+
+            // Apply the step tentatively, the next step starts by removing its closing edge (t1, last) again. The gain
+            // of the walk (t1, last) is the gain of the step before it is closed, so the gains of all steps add up
+            const vertex_t last = bestStep.walk[bestStep.walk.size() - 1];
+            tour.exchange(bestStep.walk.close());
+            for (auto v = bestStep.walk.begin() + 2; v != bestStep.walk.end(); ++v) {
+                allSteps.push_back(*v);
+            }
+            walk.clear();
+            walk.push_back(t1);
+            walk.push_back(last);
+            gain = bestStep.gain;
+        }
+
+        // No step improved the tour, undo the tentative steps
+        tour.rollback();
+        tour.discardCheckpoint();
+    }
+    return false;
+}
+
+void LinKernighanHeuristic::improveTourFiveOpt(Tour &tour) {
+    STATISTICS_TIMER(LK_SEARCH);
+
+    // As in improveTour the search is abandoned as soon as it reaches a known local optimum
+    AlternatingWalk improvingWalk;
+    if (!parameters.dontLookBits) {
+        // After every improvement the search starts from all vertices again
+        bool improved = true;
+        while (improved and knownOptima.count(tour.getHash()) == 0) {
+            improved = false;
+            for (auto t1 = startVertices.rbegin(); t1 != startVertices.rend() and !improved; ++t1) {
+                improved = applyFiveOptMove(tour, *t1, improvingWalk);
+            }
+        }
+        return;
+    }
+
+    // With don't-look bits a vertex is removed from the active vertices when no move starts at it and the vertices of
+    // the changed edges are activated again, see Parameters::dontLookBits
+    std::vector<vertex_t> activeVertices = startVertices;
+    std::vector<bool> isActive(tsplibProblem.getDimension(), false);
+    for (vertex_t v : activeVertices) {
+        isActive[v] = true;
+    }
+    while (!activeVertices.empty() and knownOptima.count(tour.getHash()) == 0) {
+        const vertex_t t1 = activeVertices.back();
+        if (applyFiveOptMove(tour, t1, improvingWalk)) {
+            for (vertex_t v : improvingWalk) {
+                if (!isActive[v]) {
+                    isActive[v] = true;
+                    activeVertices.push_back(v);
+                }
+            }
+        } else {
+            activeVertices.pop_back();
+            isActive[t1] = false;
+        }
+    }
+}
+
+void LinKernighanHeuristic::improveTour(Tour &tour) {
+    if (parameters.searchMode != LK_MODE) {
+        FastLocalSearch(tsplibProblem, candidateEdges, [this](vertex_t v, vertex_t w) {
+            return isFixed(v, w);
+        }).improve(tour, startVertices);
+        if (parameters.searchMode == FAST_MODE) {
+            return;
+        }
+    }
+
+    if (parameters.moveType == FIVE_OPT_MOVE) {
+        improveTourFiveOpt(tour);
+        return;
+    }
+    const bool limitedSearch = !parameters.breadth.empty() or parameters.maxMoveDepth != 0;
+    if (parameters.candidateOrder == REVERSE_ALPHA_ORDER) {
+        limitedSearch ? improveTour<REVERSE_ALPHA_ORDER, true>(tour) : improveTour<REVERSE_ALPHA_ORDER, false>(tour);
+    } else if (parameters.candidateOrder == LOOKAHEAD_ORDER) {
+        limitedSearch ? improveTour<LOOKAHEAD_ORDER, true>(tour) : improveTour<LOOKAHEAD_ORDER, false>(tour);
+    } else {
+        limitedSearch ? improveTour<ALPHA_ORDER, true>(tour) : improveTour<ALPHA_ORDER, false>(tour);
+    }
+}
+
+Tour LinKernighanHeuristic::createTour(const std::vector<vertex_t> &tourSequence) const {
+    Tour tour;
+    tour.setVertices(tourSequence, parameters.groupSize);
+    return tour;
+}
+
+Tour LinKernighanHeuristic::mergeWithBestTour(const Tour &tour) {
+    Tour mergedTour = mergeTours(tsplibProblem, currentBestTour, tour, parameters.groupSize);
+
+    // The parts of the tours that mergeTours could not exchange are searched by improveTour, but only with the edges
+    // of both tours as candidate edges. These are at most four per vertex, so this is much faster than a trial
+    const dimension_t dimension = tsplibProblem.getDimension();
+    std::vector<std::vector<vertex_t>> unionNeighbors(dimension);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        for (vertex_t w : {currentBestTour.predecessor(v), currentBestTour.successor(v), tour.predecessor(v),
+                           tour.successor(v)}) {
+            if (std::find(unionNeighbors[v].begin(), unionNeighbors[v].end(), w) == unionNeighbors[v].end()) {
+                unionNeighbors[v].push_back(w);
+            }
+        }
+        std::sort(unionNeighbors[v].begin(), unionNeighbors[v].end(), [this, v](vertex_t w1, vertex_t w2) {
+            return tsplibProblem.dist(v, w1) < tsplibProblem.dist(v, w2);
+        });
+    }
+    CandidateEdges unionEdges(tsplibProblem, unionNeighbors);
+    std::swap(candidateEdges, unionEdges);
+    improveTour<ALPHA_ORDER, false>(mergedTour);
+    std::swap(candidateEdges, unionEdges);
+    return mergedTour;
+}
+
 Tour
 LinKernighanHeuristic::findBestTour(std::size_t numberOfTrials, distance_t optimumTourLength, double acceptableError,
                                     bool verboseOutput) {
@@ -300,26 +782,55 @@ LinKernighanHeuristic::findBestTour(std::size_t numberOfTrials, distance_t optim
         throw std::runtime_error("The number of trials can not be lower than 1.");
     }
 
-    Tour startTour;
     Tour currentTour;
     distance_t currentBestLength = std::numeric_limits<distance_t>::max();
     std::size_t trialCount = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    improvements.clear();
+    knownOptima.clear();
+    duplicateTrials = 0;
 
     while (trialCount++ < numberOfTrials) {
         if (verboseOutput) std::cout << "Trial " << trialCount << " | " << std::flush;
 
-        startTour = generateRandomTour();
+        // The tours are moved and improved in place, only an improvement of the best tour copies it into a snapshot
+        currentTour = generateRandomTour();
         if (verboseOutput)
-            std::cout << "Length of startTour: " << tsplibProblem.length(startTour) << " | " << std::flush;
+            std::cout << "Length of startTour: " << tsplibProblem.length(currentTour) << " | " << std::flush;
 
-        currentTour = improveTour(startTour);
+        improveTour(currentTour);
         if (verboseOutput)
             std::cout << "Length of currentTour: " << tsplibProblem.length(currentTour) << " | " << std::flush;
 
+        if (!knownOptima.insert(currentTour.getHash()).second) {
+            ++duplicateTrials;
+            if (verboseOutput) std::cout << "Duplicate | " << std::flush;
+        }
+
+        // The backbone uses the tour before merging, a merged tour would often be the current best tour again
+        if (parameters.backboneSize > 0) {
+            updateBackbone(currentTour);
+            if (verboseOutput and !fixedNeighbors.empty()) {
+                const auto fixedEdges = std::count_if(fixedNeighbors.begin(), fixedNeighbors.end(), [this](vertex_t w) {
+                    return w != tsplibProblem.getDimension();
+                }) / 2;
+                std::cout << "Fixed edges: " << fixedEdges << " | " << std::flush;
+            }
+        }
+
+        // Merge the tour with the current best tour, the result is never longer than both tours
+        if (parameters.tourMerging and currentBestTour.getDimension() != 0) {
+            currentTour = mergeWithBestTour(currentTour);
+            if (verboseOutput)
+                std::cout << "Length of mergedTour: " << tsplibProblem.length(currentTour) << " | " << std::flush;
+        }
+
         // Update currentBestTour if necessary
         if (tsplibProblem.length(currentTour) < currentBestLength) {
-            currentBestTour = currentTour;
+            currentBestTour.copyFrom(currentTour);
             currentBestLength = tsplibProblem.length(currentBestTour);
+            std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+            improvements.push_back(Improvement{trialCount, elapsedTime.count(), currentBestLength});
         }
         if (verboseOutput) std::cout << "Length of currentBestTour: " << currentBestLength << std::endl;
 
@@ -330,5 +841,36 @@ LinKernighanHeuristic::findBestTour(std::size_t numberOfTrials, distance_t optim
         }
     }
 
-    return currentBestTour;
+    return createTour(currentBestTour.getSequence());
+}
+
+Tour LinKernighanHeuristic::improveTourFrom(const Tour &tour, const std::vector<vertex_t> &vertices) {
+    std::vector<vertex_t> allVertices = vertices;
+    std::swap(startVertices, allVertices);
+    Tour improvedTour = tour;
+    improveTour(improvedTour);
+    std::swap(startVertices, allVertices);
+    return improvedTour;
+}
+
+void LinKernighanHeuristic::fixEdge(vertex_t v, vertex_t w) {
+    const dimension_t dimension = tsplibProblem.getDimension();
+    if (fixedNeighbors.empty()) {
+        fixedNeighbors.assign(2 * dimension, dimension);
+    }
+    if (permanentlyFixedNeighbors.empty()) {
+        permanentlyFixedNeighbors.assign(2 * dimension, dimension);
+    }
+    for (std::vector<vertex_t> *neighbors : {&fixedNeighbors, &permanentlyFixedNeighbors}) {
+        (*neighbors)[(*neighbors)[2 * v] == dimension ? 2 * v : 2 * v + 1] = w;
+        (*neighbors)[(*neighbors)[2 * w] == dimension ? 2 * w : 2 * w + 1] = v;
+    }
+}
+
+const std::vector<LinKernighanHeuristic::Improvement> &LinKernighanHeuristic::getImprovements() const {
+    return improvements;
+}
+
+std::size_t LinKernighanHeuristic::getDuplicateTrials() const {
+    return duplicateTrials;
 }
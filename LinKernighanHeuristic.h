@@ -6,8 +6,12 @@
 #define LINKERNIGHANALGORITHM_LINKERNIGHANHEURISTIC_H
 
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <random>
+#include <unordered_set>
 #include <vector>
 #include "Tour.h"
 #include "TsplibUtils.h"
@@ -17,24 +21,57 @@
 // This class provides candidate edges for each vertex in a graph and functions for generating them
 
 class CandidateEdges {
+public:
+    enum Type {
+        ALL_NEIGHBORS, NEAREST_NEIGHBORS, ALPHA_NEAREST_NEIGHBORS, OPTIMIZED_ALPHA_NEAREST_NEIGHBORS
+    };
+
+    // A candidate edge to vertex with its distance, so the heuristic does not need to look it up
+    // The edge has no padding, on 64-bit platforms it takes 16 bytes and four edges share a cache line
+    struct Edge {
+        vertex_t vertex;
+        distance_t distance;
+    };
+
+    // The candidate edges of a single vertex, a range that can be used in a range-based for loop
+    class Range {
+    private:
+        const Edge *first;
+        const Edge *last;
+
+    public:
+        Range(const Edge *first, const Edge *last);
+
+        const Edge *begin() const;
+
+        const Edge *end() const;
+
+        std::size_t size() const;
+    };
+
 private:
-    std::vector<std::vector<vertex_t>> neighbors;
+    // The candidate edges of vertex v are edges[offsets[v]], ..., edges[offsets[v + 1] - 1], so the candidate edges of
+    // all vertices are stored one after another in a single array (compressed sparse row layout)
+    std::vector<std::size_t> offsets{0};
+    std::vector<Edge> edges;
+
+    // Append the candidate edge to w with the given distance to the last vertex
+    void addEdge(vertex_t w, distance_t distance);
+
+    // Start the candidate edges of the next vertex, must be called after the edges of every vertex were added
+    void finishVertex();
 
     // Find the k nearest neighbors in the set of vertices 0, ..., dimension by using the distCompare function that
     // decides for three vertices v, w1 and w2 if the distance between v and w1 is smaller than the distance between v
     // and w2
-    static CandidateEdges rawNearestNeighbors(dimension_t dimension, std::size_t k,
+    static CandidateEdges rawNearestNeighbors(const TsplibProblem &problem, std::size_t k,
                                               const std::function<bool(vertex_t, vertex_t, vertex_t)> &distCompare);
 
 public:
-    enum Type {
-        ALL_NEIGHBORS, NEAREST_NEIGHBORS, ALPHA_NEAREST_NEIGHBORS, OPTIMIZED_ALPHA_NEAREST_NEIGHBORS
-    };
-
     CandidateEdges() = default;
 
-    // Fill edges with dimension copies of fillValue (just as the constructor of std::vector)
-    CandidateEdges(dimension_t dimension, const std::vector<vertex_t> &fillValue);
+    // Use neighbors[v] as the candidate edges of vertex v, the distances are taken from problem
+    CandidateEdges(const TsplibProblem &problem, const std::vector<std::vector<vertex_t>> &neighbors);
 
     // For each vertex choose all edges as candidate edges
     static CandidateEdges allNeighbors(const TsplibProblem &problem);
@@ -42,20 +79,33 @@ public:
     // For each vertex choose the k edges with minimal distance as candidate edges
     static CandidateEdges nearestNeighbors(const TsplibProblem &problem, std::size_t k);
 
+    // Like nearestNeighbors, but problems with coordinates are searched with a grid (see
+    // TsplibProblem::gridNearestNeighbors) instead of comparing all pairs of vertices, so large problems need neither a
+    // distance matrix nor quadratic time. EXPLICIT and GEO problems use nearestNeighbors
+    static CandidateEdges sparseNearestNeighbors(const TsplibProblem &problem, std::size_t k);
+
     // For each vertex choose the k edges with minimal alpha distance as candidate edges
     // The alpha distance of an edge is defined as the increase in length of a 1-tree when required to contain this edge
-    static CandidateEdges alphaNearestNeighbors(const TsplibProblem &problem, std::size_t k);
+    // If streamingAlpha is true the alpha distances are computed row by row instead of being stored in a dense table
+    // (see StreamingAlphaDistances), this gives the same candidate edges with memory linear in the dimension
+    static CandidateEdges alphaNearestNeighbors(const TsplibProblem &problem, std::size_t k,
+                                                bool streamingAlpha = false);
 
     // For each vertex choose the k edges with minimal alpha distance as candidate edges
     // The alpha distances are optimized with subgradient optimization, see AlphaDistance
-    static CandidateEdges optimizedAlphaNearestNeighbors(const TsplibProblem &problem, std::size_t k);
+    static CandidateEdges optimizedAlphaNearestNeighbors(const TsplibProblem &problem, std::size_t k,
+                                                         bool streamingAlpha = false);
 
     // Create candidate edges of type candidateEdgeType with k candidate edges for each vertex
-    // k is ignored for Type::ALL_NEIGHBORS
-    static CandidateEdges create(const TsplibProblem &problem, Type candidateEdgeType, std::size_t k);
+    // k is ignored for Type::ALL_NEIGHBORS, streamingAlpha is only used for the alpha nearest neighbors
+    static CandidateEdges create(const TsplibProblem &problem, Type candidateEdgeType, std::size_t k,
+                                 bool streamingAlpha = false);
+
+    // Returns the number of vertices
+    dimension_t getDimension() const;
 
-    // Forwards the [] operator of neighbors
-    std::vector<vertex_t> &operator[](std::size_t index);
+    // Returns the candidate edges of vertex v
+    Range operator[](vertex_t v) const;
 };
 
 // ========================================== LinKernighanHeuristic class ==============================================
@@ -65,38 +115,240 @@ public:
 // for improvements can depend on previous trials.
 
 class LinKernighanHeuristic {
-private:
-    const std::size_t backtrackingDepth = 5;
-    const std::size_t infeasibilityDepth = 2;
+public:
+    // An improvement of the best tour found during findBestTour
+    struct Improvement {
+        // The trial in which the improvement was found (starting at 1)
+        std::size_t trial;
+
+        // The time since the start of findBestTour in seconds
+        double seconds;
+
+        // The length of the new best tour
+        distance_t length;
+    };
+
+    // The order in which the candidate edges of x_i are tried as the in-edge (x_i, x_{i+1}) of an alternating walk
+    enum CandidateOrder {
+        // The reverse of ALPHA_ORDER, i.e. the candidate edge with the highest alpha distance first. This was the order
+        // before the other orders were added. A limited breadth still keeps the choices with the lowest alpha distances
+        REVERSE_ALPHA_ORDER,
+        // By alpha distance and then by distance, i.e. in the order of the candidate edges. This is the default,
+        // without the pathological brg180 it gives the lowest mean gap on the default benchmark suite (see
+        // Benchmarks/candidate_order.txt)
+        ALPHA_ORDER,
+        // By decreasing g - c(x_i, x_{i+1}) + c(x_{i+1}, x_{i+2}), where g is the gain of the walk up to x_i and
+        // x_{i+2} is the tour neighbor of x_{i+1} that is farther away, i.e. by the gain after the next out-edge
+        LOOKAHEAD_ORDER
+    };
+
+    // The basic step by which an alternating walk is extended
+    enum MoveType {
+        // One edge is added and one edge is removed in every step, see improveTour
+        LK_MOVE,
+        // Up to five edges are added and removed in every step, chosen by an exhaustive search over the candidate
+        // edges, see improveTourFiveOpt
+        FIVE_OPT_MOVE
+    };
+
+    // How improveTour improves a start tour
+    enum SearchMode {
+        // Search improving moves made of steps of the move type
+        LK_MODE,
+        // Only search improving 2-opt and Or-opt moves, see FastLocalSearch. This is much faster, but the tours are
+        // worse
+        FAST_MODE,
+        // Improve the start tour with FAST_MODE first and then with LK_MODE
+        FAST_LK_MODE
+    };
+
+    // The parameters of the search
+    struct Parameters {
+        SearchMode searchMode;
+
+        MoveType moveType;
+
+        // If no improvement is found, the search backtracks to the choice of x_i with i = min(i - 1, backtrackingDepth)
+        std::size_t backtrackingDepth;
+
+        // Up to x_infeasibilityDepth the out-edges may be chosen such that closing the walk does not give a tour
+        std::size_t infeasibilityDepth;
 
+        // The maximum number of edges that are exchanged by a single move (a k-opt move with k = maxMoveDepth), 0 means
+        // that the number is not limited. The value 1 would forbid all moves, so it is not allowed
+        std::size_t maxMoveDepth;
+
+        CandidateOrder candidateOrder;
+
+        // breadth[j] is the maximum number of candidate edges tried as the in-edge (x_{2j+1}, x_{2j+2}), the last value
+        // is used for all following in-edges. If it is empty the number is not limited. Every value must be at least 1
+        std::vector<std::size_t> breadth;
+
+        // The groupSize of the tours (see TwoLevelTreeTour), 0 means TwoLevelTreeTour::defaultGroupSize
+        dimension_t groupSize;
+
+        // If true, the tour of every trial is merged with the current best tour (see mergeWithBestTour)
+        bool tourMerging;
+
+        // The number of recent trial tours whose edge frequencies guide generateRandomTour (see recentTours), 0 means
+        // that only the edges of the current best tour are preferred
+        std::size_t backboneSize;
+
+        // If true, the edges contained in all of the last backboneSize distinct trial tours are fixed, i.e. the LK
+        // search and FastLocalSearch never remove them from the tour. Nothing is fixed before there are at least two
+        // distinct tours, so never a whole tour is fixed, and a trial that returns one of them again releases the fixed
+        // edges until the next distinct tour
+        bool fixBackbone;
+
+        // If true, a vertex is only tried as x_0 again after one of its tour edges changed. Otherwise all vertices are
+        // tried again after every improvement, which makes the search quadratic in the dimension (FAST_MODE always
+        // uses don't-look bits)
+        bool dontLookBits;
+
+        // The default parameters
+        Parameters() : searchMode(LK_MODE), moveType(LK_MOVE), backtrackingDepth(5), infeasibilityDepth(2),
+                       maxMoveDepth(0), candidateOrder(ALPHA_ORDER), groupSize(0), tourMerging(false),
+                       backboneSize(0), fixBackbone(false), dontLookBits(false) {}
+    };
+
+private:
     // The TsplibProblem that should be solved
     TsplibProblem tsplibProblem;
 
-    // The best solution tour found by the algorithm (initially none)
-    Tour currentBestTour;
+    // The best solution tour found by the algorithm (initially none), it is only read, so a snapshot suffices
+    TourSnapshot currentBestTour;
 
     // The candidate edges used
     CandidateEdges candidateEdges;
 
+    // The parameters of the search
+    Parameters parameters;
+
+    // The source of all random decisions, a fixed seed makes the results reproducible
+    std::mt19937 randomNumberGenerator;
+
+    // All vertices in the order of the TSPLIB file, improveTour tries them as the first vertex of an alternating walk
+    // from the back to the front. So the search does not depend on a renumbering of the vertices, otherwise every
+    // search after an improvement would first try the vertices with the highest numbers, which are all close to each
+    // other after TsplibProblem::renumber
+    std::vector<vertex_t> startVertices;
+
+    // All improvements of the best tour in the last call to findBestTour
+    std::vector<Improvement> improvements;
+
+    // The hashes (see BaseTour::getHash) of the tours of all trials in the last call to findBestTour. These are local
+    // optima, so improveTour abandons the search as soon as it reaches one of them
+    std::unordered_set<std::uint64_t> knownOptima;
+
+    // The number of trials in the last call to findBestTour whose tour was found by an earlier trial
+    std::size_t duplicateTrials = 0;
+
+    // The distinct tours of the last trials, at most parameters.backboneSize (the oldest first), the edges that many of
+    // them contain are likely to be in an optimal tour
+    std::deque<TourSnapshot> recentTours;
+
+    // The edges {v, fixedNeighbors[2 * v]} and {v, fixedNeighbors[2 * v + 1]} are fixed, a value equal to the
+    // dimension means that there is no such edge. Empty if no edges are fixed
+    std::vector<vertex_t> fixedNeighbors;
+
+    // The edges fixed by fixEdge in the same format, they stay fixed when the fixed backbone changes
+    std::vector<vertex_t> permanentlyFixedNeighbors;
+
+    // Returns the number of recentTours that contain the edge {v, w}. Without recentTours it is 1 if the current best
+    // tour contains the edge and 0 otherwise
+    std::size_t edgeFrequency(vertex_t v, vertex_t w) const;
+
+    // Returns whether the edge {v, w} is fixed
+    bool isFixed(vertex_t v, vertex_t w) const;
+
+    // Adds tour to recentTours unless it is already contained (by its hash, then the fixed backbone is released),
+    // removes the oldest one if there are more than parameters.backboneSize and fixes the edges contained in all of
+    // them if parameters.fixBackbone is true. The edges fixed by fixEdge stay fixed. The snapshot of the oldest tour
+    // is reused
+    void updateBackbone(const Tour &tour);
+
     // Chooses a random element from the vector elements
-    static vertex_t chooseRandomElement(const std::vector<vertex_t> &elements);
+    vertex_t chooseRandomElement(const std::vector<vertex_t> &elements);
 
-    // Generates a random good tour based on the current best tour and the candidate edges
+    // Generates a random good tour based on the candidate edges and their frequencies in the recent tours (or the
+    // current best tour), it contains the fixed edges wherever possible
     Tour generateRandomTour();
 
     // The core part of the algorithm as described in Combinatorial Optimization
-    Tour improveTour(const Tour &startTour);
+    // It is compiled for every candidate order and with and without the limits of breadth and maxMoveDepth, so the
+    // search with the default parameters does not check them in every step
+    template<CandidateOrder candidateOrder, bool limitedSearch>
+    void improveTour(Tour &currentTour);
+
+    // The best extension of an alternating walk by a 5-opt step that was found by searchFiveOptStep
+    struct FiveOptStep {
+        // The extended walk, it gives a tour when it is closed
+        AlternatingWalk walk;
+
+        // The gain of walk before it is closed (the length of the removed edges minus the length of the added edges)
+        signed_distance_t gain;
+    };
+
+    // Extends walk by at most remainingEdges added and removed edges in every possible way, such that every added edge
+    // is a candidate edge, no edge of previousSteps is added or removed and the gain of walk stays positive. gain is
+    // the gain of walk before it is closed.
+    // If a closed extension improves tour, it is stored in improvingWalk and true is returned (walk is not restored
+    // in that case). Otherwise bestStep is updated with the extensions by exactly remainingEdges edges that give a
+    // tour when they are closed
+    bool searchFiveOptStep(const Tour &tour, AlternatingWalk &walk, const AlternatingWalk &previousSteps,
+                           signed_distance_t gain, std::size_t remainingEdges, FiveOptStep &bestStep,
+                           AlternatingWalk &improvingWalk);
+
+    // Searches an improving move for tour by extending the alternating walks from t1 by 5-opt steps: if no step
+    // improves the tour, the step with the highest gain is applied tentatively and the search continues from its end,
+    // as long as the gain stays positive. If this finds no improvement, the tentative steps are rolled back (see
+    // BaseTour::rollback). Fixed edges are never removed. Applies the first improving move to tour, stores all its
+    // steps as one walk in improvingWalk and returns whether there was one
+    bool applyFiveOptMove(Tour &tour, vertex_t t1, AlternatingWalk &improvingWalk);
+
+    // Improves tour with 5-opt steps (see applyFiveOptMove) until no improving move is found or the tour is a known
+    // local optimum, with don't-look bits if parameters.dontLookBits is true
+    void improveTourFiveOpt(Tour &tour);
+
+    // Improves tour as given by the search mode, the LK search calls improveTour or improveTourFiveOpt with the
+    // template arguments that match the parameters. The tour is improved in place, so a trial does not copy it
+    void improveTour(Tour &tour);
+
+    // Returns the tour with the given sequence and the groupSize of the parameters
+    Tour createTour(const std::vector<vertex_t> &tourSequence) const;
+
+    // Merges tour with the current best tour by mergeTours and improves the result by improveTour with only the edges
+    // of both tours as candidate edges. The result is never longer than both tours
+    Tour mergeWithBestTour(const Tour &tour);
 
 public:
     LinKernighanHeuristic() = delete;
 
-    explicit LinKernighanHeuristic(TsplibProblem &tsplibProblem, CandidateEdges candidateEdges);
+    // Initialize the heuristic, every run with the same seed and parameters gives the same result
+    explicit LinKernighanHeuristic(TsplibProblem &tsplibProblem, CandidateEdges candidateEdges,
+                                   std::mt19937::result_type seed = std::random_device{}(),
+                                   Parameters parameters = Parameters());
 
     // Return the best tour found after numberOfTrials trials. If the relative increase of the length of the best tour
     // compared to optimumTourLength is below acceptableError the algorithm will stop and return it immediately.
     // verboseOutput turns debug output on or off
     Tour findBestTour(std::size_t numberOfTrials, distance_t optimumTourLength = 0, double acceptableError = 0,
                       bool verboseOutput = true);
+
+    // Improves tour by the search given by the parameters like a single trial, but only alternating walks that start at
+    // one of vertices are searched. This repairs a tour that is only bad in a few places, e.g. where the tours of
+    // subproblems were joined
+    Tour improveTourFrom(const Tour &tour, const std::vector<vertex_t> &vertices);
+
+    // Fixes the edge {v, w}, i.e. no search removes it and generateRandomTour always adds it. Expects that v and w have
+    // at most one fixed edge so far. The edge stays fixed when parameters.fixBackbone fixes the backbone
+    void fixEdge(vertex_t v, vertex_t w);
+
+    // Returns every improvement of the best tour found in the last call to findBestTour in chronological order
+    const std::vector<Improvement> &getImprovements() const;
+
+    // Returns the number of trials in the last call to findBestTour that ended in the tour of an earlier trial
+    std::size_t getDuplicateTrials() const;
 };
 
 #endif //LINKERNIGHANALGORITHM_LINKERNIGHANHEURISTIC_H
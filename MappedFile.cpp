@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.h"
+
+void MappedFile::close() {
+    if (mapped) {
+        munmap(const_cast<char *>(fileData), fileSize);
+    } else {
+        delete[] fileData;
+    }
+    fileData = nullptr;
+    fileSize = 0;
+    mapped = false;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : fileData(other.fileData), fileSize(other.fileSize),
+                                                      mapped(other.mapped) {
+    other.fileData = nullptr;
+    other.fileSize = 0;
+    other.mapped = false;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(fileData, other.fileData);
+        std::swap(fileSize, other.fileSize);
+        std::swap(mapped, other.mapped);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+std::string MappedFile::open(const std::string &fileName) {
+    close();
+    int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return "Could not open the file '" + fileName + "': " + std::strerror(errno);
+    }
+
+    struct stat fileStatus{};
+    if (fstat(fileDescriptor, &fileStatus) == 0 and S_ISREG(fileStatus.st_mode) and fileStatus.st_size > 0) {
+        fileSize = static_cast<std::size_t>(fileStatus.st_size);
+        void *address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (address != MAP_FAILED) {
+            // The file is read from the start to the end exactly once
+            madvise(address, fileSize, MADV_SEQUENTIAL);
+            fileData = static_cast<const char *>(address);
+            mapped = true;
+            ::close(fileDescriptor);
+            return "";
+        }
+        fileSize = 0;
+    }
+
+    // Fall back to reading the file into memory
+    std::string content;
+    char buffer[1 << 16];
+    ssize_t bytesRead;
+    while ((bytesRead = read(fileDescriptor, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, static_cast<std::size_t>(bytesRead));
+    }
+    ::close(fileDescriptor);
+    if (bytesRead < 0) {
+        return "Could not read the file '" + fileName + "': " + std::strerror(errno);
+    }
+    char *copy = new char[content.size()];
+    std::memcpy(copy, content.data(), content.size());
+    fileData = copy;
+    fileSize = content.size();
+    return "";
+}
+
+void MappedFile::adviseRandomAccess() const {
+    if (mapped) {
+        madvise(const_cast<char *>(fileData), fileSize, MADV_RANDOM);
+    }
+}
+
+const char *MappedFile::data() const {
+    return fileData;
+}
+
+std::size_t MappedFile::size() const {
+    return fileSize;
+}
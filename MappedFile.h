@@ -0,0 +1,51 @@
+#ifndef LINKERNIGHANALGORITHM_MAPPEDFILE_H
+#define LINKERNIGHANALGORITHM_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// ================================================ MappedFile class ===================================================
+
+// This class maps a whole file read-only into memory, so that it can be parsed without copying it into buffers first.
+// If the file cannot be mapped (e.g. because it is a pipe), it is read into memory instead.
+
+class MappedFile {
+private:
+    const char *fileData = nullptr;
+    std::size_t fileSize = 0;
+
+    // Whether fileData was returned by mmap, otherwise it was allocated with new[] (or is nullptr)
+    bool mapped = false;
+
+    // Unmap or delete the data and reset all members
+    void close();
+
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+
+    // Map the file fileName into memory, a previously opened file is closed
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string open(const std::string &fileName);
+
+    // Tell the operating system that the file will be accessed randomly from now on, by default it is expected to be
+    // read sequentially
+    void adviseRandomAccess() const;
+
+    // Returns a pointer to the first byte of the file, the data is not null-terminated
+    const char *data() const;
+
+    // Returns the size of the file in bytes
+    std::size_t size() const;
+};
+
+#endif //LINKERNIGHANALGORITHM_MAPPEDFILE_H
@@ -0,0 +1,127 @@
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include "LinKernighanHeuristic.h"
+#include "MemoryPlan.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================== MemoryPlan class =====================================================
+
+MemoryPlan MemoryPlan::create(const TsplibProblem &problem, CandidateEdges::Type candidateEdgeType, std::size_t k,
+                              std::size_t memoryLimitBytes, bool sparseCandidateEdges) {
+    const dimension_t dimension = problem.getDimension();
+    MemoryPlan plan;
+    plan.memoryLimitBytes = memoryLimitBytes;
+
+    // At most three coordinates and for GEO two radians per vertex
+    plan.problemBytes = dimension * 5 * sizeof(double);
+
+    const std::size_t edgesPerVertex =
+            !sparseCandidateEdges and candidateEdgeType == CandidateEdges::ALL_NEIGHBORS ? dimension - 1 : k;
+    plan.candidateEdgeBytes = 2 * ((dimension + 1) * sizeof(std::size_t) +
+                                   dimension * edgesPerVertex * sizeof(CandidateEdges::Edge));
+
+    // The tours and the vectors of all vertices used by generateRandomTour and improveTour
+    plan.tourBytes = dimension * (NUMBER_OF_TOURS * TOUR_BYTES_PER_VERTEX + 3 * sizeof(vertex_t));
+
+    // The 1-tree, the arrays of Prim's algorithm and the penalties are needed by both kinds of alpha distances, the
+    // dense alpha distances add the tables alpha and beta
+    const bool usesAlpha = !sparseCandidateEdges and
+                           (candidateEdgeType == CandidateEdges::ALPHA_NEAREST_NEIGHBORS or
+                            candidateEdgeType == CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS);
+    const std::size_t streamingAlphaBytes = usesAlpha ? dimension * 8 * sizeof(signed_distance_t) : 0;
+    const std::size_t denseAlphaBytes =
+            streamingAlphaBytes + 2 * dimension * (VECTOR_BYTES + dimension * sizeof(distance_t));
+    plan.alphaStorage = usesAlpha ? STREAMING_ALPHA : NO_ALPHA;
+    plan.alphaBytes = streamingAlphaBytes;
+
+    const std::size_t fixedBytes = plan.problemBytes + plan.candidateEdgeBytes + plan.tourBytes + plan.alphaBytes;
+    const std::size_t availableBytes = memoryLimitBytes > fixedBytes ? memoryLimitBytes - fixedBytes : 0;
+
+    // The distance cache should at least be able to keep the candidate edges and as many other distances
+    const std::size_t minimumCacheBytes = 2 * ((dimension + 1) * sizeof(std::size_t) +
+                                               dimension * edgesPerVertex * (sizeof(vertex_t) + sizeof(distance_t)));
+    const std::size_t fullMatrixBytes = dimension * dimension * sizeof(distance_t);
+    const std::size_t triangularMatrixBytes = dimension * (dimension + 1) / 2 * sizeof(distance_t);
+
+    if (problem.getEdgeWeightType() == TsplibProblem::EXPLICIT) {
+        plan.distanceStorage = EXPLICIT_MATRIX;
+        plan.distanceBytes = problem.getMatrixBytes();
+    } else if (sparseCandidateEdges) {
+        // Like without a memory limit, the cells and levels store their own distances
+        plan.distanceStorage = ON_THE_FLY;
+        plan.distanceBytes = 0;
+    } else if (fullMatrixBytes <= availableBytes) {
+        plan.distanceStorage = FULL_MATRIX;
+        plan.distanceBytes = fullMatrixBytes;
+    } else if (triangularMatrixBytes <= availableBytes) {
+        plan.distanceStorage = TRIANGULAR_MATRIX;
+        plan.distanceBytes = triangularMatrixBytes;
+    } else if (minimumCacheBytes <= availableBytes) {
+        plan.distanceStorage = CACHED;
+        plan.distanceBytes = availableBytes;
+    } else {
+        plan.distanceStorage = ON_THE_FLY;
+        plan.distanceBytes = 0;
+    }
+
+    if (usesAlpha and fixedBytes - streamingAlphaBytes + plan.distanceBytes + denseAlphaBytes <= memoryLimitBytes) {
+        plan.alphaStorage = DENSE_ALPHA;
+        plan.alphaBytes = denseAlphaBytes;
+    }
+
+    return plan;
+}
+
+void MemoryPlan::apply(TsplibProblem &problem) const {
+    switch (distanceStorage) {
+        case FULL_MATRIX:
+            problem.setDistanceStorage(true, 0, false);
+            break;
+        case TRIANGULAR_MATRIX:
+            problem.setDistanceStorage(true, 0, true);
+            break;
+        case CACHED:
+            problem.setDistanceStorage(false, distanceBytes, false);
+            break;
+        case ON_THE_FLY:
+            problem.setDistanceStorage(false, 0, false);
+            break;
+        case EXPLICIT_MATRIX:
+            break;
+    }
+}
+
+bool MemoryPlan::useStreamingAlpha() const {
+    return alphaStorage == STREAMING_ALPHA;
+}
+
+std::size_t MemoryPlan::estimatedBytes() const {
+    return problemBytes + distanceBytes + candidateEdgeBytes + alphaBytes + tourBytes;
+}
+
+bool MemoryPlan::isWithinLimit() const {
+    return estimatedBytes() <= memoryLimitBytes;
+}
+
+std::string MemoryPlan::toString() const {
+    const char *distanceStorageNames[] = {"full matrix", "triangular matrix", "cache", "computed when needed",
+                                          "explicit matrix of the problem"};
+    const char *alphaStorageNames[] = {"not needed", "dense tables", "computed row by row"};
+    auto megabytes = [](std::size_t bytes) { return static_cast<double>(bytes) / (1024 * 1024); };
+
+    std::ostringstream result;
+    result << std::fixed << std::setprecision(1);
+    result << "Memory plan for a limit of " << megabytes(memoryLimitBytes) << " MB, estimated usage "
+           << megabytes(estimatedBytes()) << " MB" << std::endl;
+    result << "    distances: " << distanceStorageNames[distanceStorage] << " (" << megabytes(distanceBytes) << " MB)"
+           << std::endl;
+    result << "    alpha distances: " << alphaStorageNames[alphaStorage] << " (" << megabytes(alphaBytes) << " MB)"
+           << std::endl;
+    result << "    candidate edges: " << megabytes(candidateEdgeBytes) << " MB" << std::endl;
+    result << "    tours: " << megabytes(tourBytes) << " MB" << std::endl;
+    result << "    coordinates: " << megabytes(problemBytes) << " MB" << std::endl;
+    return result.str();
+}
@@ -0,0 +1,84 @@
+#ifndef LINKERNIGHANALGORITHM_MEMORYPLAN_H
+#define LINKERNIGHANALGORITHM_MEMORYPLAN_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================== MemoryPlan class =====================================================
+
+// This class chooses how the distances and the alpha distances are stored, such that the estimated peak memory usage
+// stays below a limit. The estimate is the sum of the large data structures that exist at the same time:
+// - the coordinates of the problem and the distances (a matrix, a distance cache or nothing)
+// - the candidate edges, which are copied once into the heuristic
+// - the alpha distances while the candidate edges are computed (two dense tables or a few arrays of the dimension)
+// - the tours of the heuristic
+// Faster storage is preferred: a full matrix over a triangular matrix over a cache over computing every distance when
+// it is needed. The distances are chosen first, because they are used in every trial, while the alpha distances are
+// only needed once. With sparse candidate edges (the nearest neighbors found with a grid, which the partitioned and the
+// multi-level solver use for large problems) the distances of the whole problem are computed when needed and no alpha
+// distances are planned, because a matrix and the alpha distances would need quadratic time for the whole problem.
+
+class MemoryPlan {
+public:
+    enum DistanceStorage {
+        FULL_MATRIX, TRIANGULAR_MATRIX, CACHED, ON_THE_FLY, EXPLICIT_MATRIX
+    };
+
+    enum AlphaStorage {
+        NO_ALPHA, DENSE_ALPHA, STREAMING_ALPHA
+    };
+
+private:
+    // The estimated number of bytes for every vertex of a tour, TwoLevelTreeTour needs a list node with the
+    // allocation overhead and an iterator per vertex
+    static const std::size_t TOUR_BYTES_PER_VERTEX = 64;
+
+    // The number of tours that exist at the same time during findBestTour
+    static const std::size_t NUMBER_OF_TOURS = 5;
+
+    // The overhead of a std::vector that is stored for every vertex
+    static const std::size_t VECTOR_BYTES = sizeof(std::vector<vertex_t>);
+
+    DistanceStorage distanceStorage = ON_THE_FLY;
+    AlphaStorage alphaStorage = NO_ALPHA;
+
+    std::size_t memoryLimitBytes = 0;
+
+    // The estimated bytes of every part, see above
+    std::size_t problemBytes = 0;
+    std::size_t distanceBytes = 0;
+    std::size_t candidateEdgeBytes = 0;
+    std::size_t alphaBytes = 0;
+    std::size_t tourBytes = 0;
+
+public:
+    MemoryPlan() = default;
+
+    // Choose the storage for problem with candidate edges of type candidateEdgeType with k edges per vertex, such that
+    // the estimated memory usage is at most memoryLimitBytes. If that is not possible the storage with the least memory
+    // usage is chosen. If sparseCandidateEdges is true the candidate edges are computed by
+    // CandidateEdges::sparseNearestNeighbors and candidateEdgeType is ignored
+    static MemoryPlan create(const TsplibProblem &problem, CandidateEdges::Type candidateEdgeType, std::size_t k,
+                             std::size_t memoryLimitBytes, bool sparseCandidateEdges = false);
+
+    // Change the storage of the distances of problem according to this plan
+    void apply(TsplibProblem &problem) const;
+
+    // Returns whether the alpha distances should be computed row by row (see StreamingAlphaDistances)
+    bool useStreamingAlpha() const;
+
+    // Returns the estimated peak memory usage in bytes
+    std::size_t estimatedBytes() const;
+
+    // Returns whether the estimated peak memory usage is at most the memory limit
+    bool isWithinLimit() const;
+
+    // Returns a description of the plan with the estimated memory usage of every part
+    std::string toString() const;
+};
+
+#endif //LINKERNIGHANALGORITHM_MEMORYPLAN_H
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "MultilevelSolver.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================ MultilevelSolver class =================================================
+
+MultilevelSolver::MultilevelSolver(TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                                   CandidateEdges::Type candidateEdgeType, std::size_t numberOfCandidateEdges,
+                                   std::mt19937::result_type seed, LinKernighanHeuristic::Parameters parameters)
+        : tsplibProblem(tsplibProblem), candidateEdges(candidateEdges), candidateEdgeType(candidateEdgeType),
+          numberOfCandidateEdges(numberOfCandidateEdges), seed(seed), parameters(std::move(parameters)),
+          randomNumberGenerator(seed) {}
+
+MultilevelSolver::Level MultilevelSolver::coarsen(const TsplibProblem &problem,
+                                                  const CandidateEdges &problemCandidateEdges) {
+    const dimension_t dimension = problem.getDimension();
+    std::vector<vertex_t> order(dimension);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), randomNumberGenerator);
+
+    // The candidate edges are ordered by their alpha distance and then by their distance, so the first unmatched one
+    // is the cheapest
+    Level level;
+    std::vector<bool> isMatched(dimension, false);
+    for (vertex_t v : order) {
+        if (isMatched[v]) {
+            continue;
+        }
+        isMatched[v] = true;
+        level.members.push_back({v});
+        for (const CandidateEdges::Edge &edge : problemCandidateEdges[v]) {
+            if (!isMatched[edge.vertex]) {
+                isMatched[edge.vertex] = true;
+                level.members.back().push_back(edge.vertex);
+                break;
+            }
+        }
+    }
+
+    // Every pair is represented by its first vertex, a problem without a matrix gets coarser problems without one
+    std::vector<vertex_t> representatives;
+    representatives.reserve(level.members.size());
+    for (const std::vector<vertex_t> &members : level.members) {
+        representatives.push_back(members.front());
+    }
+    level.problem = problem.subproblem(representatives, problem.getMatrixBytes() != 0);
+
+    // The candidate edges of a pair are the candidate edges of its members mapped to the pairs they belong to and
+    // ordered by distance, so no level needs the quadratic time of CandidateEdges::create
+    std::vector<vertex_t> coarseVertexOf(dimension);
+    for (vertex_t c = 0; c < level.members.size(); ++c) {
+        for (vertex_t v : level.members[c]) {
+            coarseVertexOf[v] = c;
+        }
+    }
+    std::vector<std::vector<vertex_t>> neighbors(level.members.size());
+    std::vector<std::pair<distance_t, vertex_t>> choices;
+    for (vertex_t c = 0; c < level.members.size(); ++c) {
+        choices.clear();
+        for (vertex_t v : level.members[c]) {
+            for (const CandidateEdges::Edge &edge : problemCandidateEdges[v]) {
+                const vertex_t d = coarseVertexOf[edge.vertex];
+                if (d != c) {
+                    choices.emplace_back(level.problem.dist(c, d), d);
+                }
+            }
+        }
+        std::sort(choices.begin(), choices.end());
+        choices.erase(std::unique(choices.begin(), choices.end()), choices.end());
+        choices.resize(std::min(choices.size(), numberOfCandidateEdges));
+        for (const auto &choice : choices) {
+            neighbors[c].push_back(choice.second);
+        }
+    }
+    level.candidateEdges = CandidateEdges(level.problem, neighbors);
+    return level;
+}
+
+Tour MultilevelSolver::expand(const TsplibProblem &fineProblem, const Level &level, const Tour &coarseTour) const {
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(fineProblem.getDimension());
+    vertex_t c = 0;
+    do {
+        const vertex_t next = coarseTour.successor(c);
+        const std::vector<vertex_t> &members = level.members[c];
+        if (members.size() == 1 or tourSequence.empty()) {
+            tourSequence.insert(tourSequence.end(), members.begin(), members.end());
+        } else {
+            // Keep the order of the pair if it is shorter from the previous vertex to the representative of the next
+            // vertex
+            const vertex_t before = tourSequence.back();
+            const vertex_t after = level.members[next].front();
+            const distance_t inOrder = fineProblem.dist(before, members[0]) + fineProblem.dist(members[1], after);
+            const distance_t reversed = fineProblem.dist(before, members[1]) + fineProblem.dist(members[0], after);
+            if (inOrder <= reversed) {
+                tourSequence.push_back(members[0]);
+                tourSequence.push_back(members[1]);
+            } else {
+                tourSequence.push_back(members[1]);
+                tourSequence.push_back(members[0]);
+            }
+        }
+        c = next;
+    } while (c != 0);
+
+    Tour tour;
+    tour.setVertices(tourSequence, parameters.groupSize);
+    return tour;
+}
+
+Tour MultilevelSolver::solve(dimension_t coarsestSize, std::size_t numberOfTrials, bool verboseOutput) {
+    // levels[l] is made from the problem of levels[l - 1], levels[0] from the whole problem. A matching that removes
+    // less than a tenth of the vertices makes no progress, then the coarsening stops early
+    std::vector<Level> levels;
+    while (true) {
+        const TsplibProblem &problem = levels.empty() ? tsplibProblem : levels.back().problem;
+        const CandidateEdges &problemCandidateEdges = levels.empty() ? candidateEdges : levels.back().candidateEdges;
+        if (problem.getDimension() <= coarsestSize) {
+            break;
+        }
+        Level level = coarsen(problem, problemCandidateEdges);
+        if (level.members.size() < 3 or 10 * level.members.size() > 9 * problem.getDimension()) {
+            break;
+        }
+        levels.push_back(std::move(level));
+        if (verboseOutput) {
+            std::cout << "Level " << levels.size() << " has " << levels.back().members.size() << " vertices"
+                      << std::endl;
+        }
+    }
+
+    // The coarsest problem is small enough to get candidate edges of the chosen type
+    if (!levels.empty() and levels.back().problem.getDimension() <= coarsestSize) {
+        Level &coarsest = levels.back();
+        coarsest.candidateEdges = CandidateEdges::create(
+                coarsest.problem, candidateEdgeType, std::min(numberOfCandidateEdges, coarsest.members.size() - 1));
+    }
+
+    // Solve the coarsest problem
+    Tour tour;
+    {
+        TsplibProblem &problem = levels.empty() ? tsplibProblem : levels.back().problem;
+        const CandidateEdges &problemCandidateEdges = levels.empty() ? candidateEdges : levels.back().candidateEdges;
+        LinKernighanHeuristic heuristic(problem, problemCandidateEdges, seed, parameters);
+        tour = heuristic.findBestTour(numberOfTrials, 0, 0, false);
+        if (verboseOutput) std::cout << "Length of the coarsest tour: " << problem.length(tour) << std::endl;
+    }
+
+    // Expand the tour level by level and search improvements from every vertex, the don't-look bits make the search
+    // of a tour that only needs local repairs about linear in the dimension
+    LinKernighanHeuristic::Parameters refinementParameters = parameters;
+    refinementParameters.dontLookBits = true;
+    for (std::size_t l = levels.size(); l > 0; --l) {
+        TsplibProblem &fineProblem = l == 1 ? tsplibProblem : levels[l - 2].problem;
+        const CandidateEdges &fineCandidateEdges = l == 1 ? candidateEdges : levels[l - 2].candidateEdges;
+        tour = expand(fineProblem, levels[l - 1], tour);
+
+        std::vector<vertex_t> allVertices(fineProblem.getDimension());
+        std::iota(allVertices.begin(), allVertices.end(), 0);
+        const auto levelSeed = seed + static_cast<std::mt19937::result_type>(l);
+        LinKernighanHeuristic heuristic(fineProblem, fineCandidateEdges, levelSeed, refinementParameters);
+        tour = heuristic.improveTourFrom(tour, allVertices);
+        if (verboseOutput) {
+            std::cout << "Length of the tour on level " << l - 1 << ": " << fineProblem.length(tour) << std::endl;
+        }
+
+        // The coarser level is not needed anymore
+        levels.pop_back();
+    }
+    return tour;
+}
@@ -0,0 +1,73 @@
+#ifndef LINKERNIGHANALGORITHM_MULTILEVELSOLVER_H
+#define LINKERNIGHANALGORITHM_MULTILEVELSOLVER_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// =========================================== MultilevelSolver class ==================================================
+
+// This class solves large problems by the multi-level approach of Walshaw: the vertices are matched in pairs along
+// short candidate edges and every pair is replaced by one of its vertices, which gives a coarser problem with about
+// half as many vertices. This is repeated until the problem is small enough to be solved by the LinKernighanHeuristic.
+// Then the levels are uncoarsened one after another: every vertex of the tour is expanded into the vertices of its
+// pair and the expanded tour is improved by a single LK search with don't-look bits (see Parameters::dontLookBits),
+// which only has to repair the tour locally, because the coarser tour is already good.
+
+class MultilevelSolver {
+private:
+    // A coarser problem and how its vertices are made from the vertices of the next finer problem
+    struct Level {
+        TsplibProblem problem;
+
+        CandidateEdges candidateEdges;
+
+        // Vertex c of problem represents the vertices members[c] of the finer problem (one or two), it is the first of
+        // them
+        std::vector<std::vector<vertex_t>> members;
+    };
+
+    TsplibProblem &tsplibProblem;
+
+    // The candidate edges of the whole problem
+    const CandidateEdges &candidateEdges;
+
+    // The candidate edges of the coarsest problem are created with these arguments (see CandidateEdges::create), the
+    // other coarser problems keep numberOfCandidateEdges candidate edges that are mapped from the finer problem
+    CandidateEdges::Type candidateEdgeType;
+    std::size_t numberOfCandidateEdges;
+
+    std::mt19937::result_type seed;
+
+    LinKernighanHeuristic::Parameters parameters;
+
+    // The source of the random order in which the vertices are matched
+    std::mt19937 randomNumberGenerator;
+
+    // Matches the vertices of problem in a random order with their first unmatched candidate edge and returns the
+    // coarser problem of the pairs. The candidate edges of a pair are the nearest pairs that a candidate edge of one of
+    // its members leads to
+    Level coarsen(const TsplibProblem &problem, const CandidateEdges &problemCandidateEdges);
+
+    // Returns the tour of the finer problem of level that visits the members of every vertex of coarseTour one after
+    // another, the members of a pair in the order that is shorter after the previous vertex
+    Tour expand(const TsplibProblem &fineProblem, const Level &level, const Tour &coarseTour) const;
+
+public:
+    MultilevelSolver() = delete;
+
+    // The problem and the candidate edges must outlive this object
+    MultilevelSolver(TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                     CandidateEdges::Type candidateEdgeType, std::size_t numberOfCandidateEdges,
+                     std::mt19937::result_type seed, LinKernighanHeuristic::Parameters parameters);
+
+    // Solve the problem by coarsening it until at most coarsestSize vertices remain, solving the coarsest problem with
+    // numberOfTrials trials and refining the tour on every finer level. verboseOutput turns debug output on or off
+    // Expects coarsestSize >= 3
+    Tour solve(dimension_t coarsestSize, std::size_t numberOfTrials, bool verboseOutput = true);
+};
+
+#endif //LINKERNIGHANALGORITHM_MULTILEVELSOLVER_H
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "PartitionedSolver.h"
+#include "ThreadPool.h"
+#include "Tour.h"
+#include "TourMerging.h"
+#include "TsplibUtils.h"
+
+// =========================================== PartitionedSolver class =================================================
+
+PartitionedSolver::PartitionedSolver(TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                                     CandidateEdges::Type candidateEdgeType, std::size_t numberOfCandidateEdges,
+                                     std::mt19937::result_type seed, LinKernighanHeuristic::Parameters parameters)
+        : tsplibProblem(tsplibProblem), candidateEdges(candidateEdges), candidateEdgeType(candidateEdgeType),
+          numberOfCandidateEdges(numberOfCandidateEdges), seed(seed), parameters(std::move(parameters)) {}
+
+std::vector<vertex_t> PartitionedSolver::solveCell(const std::vector<vertex_t> &cell, std::size_t numberOfTrials,
+                                                   std::mt19937::result_type cellSeed) const {
+    if (cell.size() < 3) {
+        // Every order is a tour
+        return cell;
+    }
+
+    // The nearest neighbors of a cell are found with a grid. The don't-look bits make every trial about linear in the
+    // size of the cell
+    TsplibProblem subproblem = tsplibProblem.subproblem(cell);
+    const std::size_t k = std::min(numberOfCandidateEdges, cell.size() - 1);
+    CandidateEdges subproblemCandidateEdges;
+    if (candidateEdgeType == CandidateEdges::NEAREST_NEIGHBORS) {
+        subproblemCandidateEdges = CandidateEdges::sparseNearestNeighbors(subproblem, k);
+    } else {
+        subproblemCandidateEdges = CandidateEdges::create(subproblem, candidateEdgeType, k);
+    }
+    LinKernighanHeuristic::Parameters cellParameters = parameters;
+    cellParameters.dontLookBits = true;
+    LinKernighanHeuristic heuristic(subproblem, std::move(subproblemCandidateEdges), cellSeed, cellParameters);
+    const Tour tour = heuristic.findBestTour(numberOfTrials, 0, 0, false);
+
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(cell.size());
+    vertex_t v = 0;
+    do {
+        tourSequence.push_back(cell[v]);
+        v = tour.successor(v);
+    } while (v != 0);
+    return tourSequence;
+}
+
+std::vector<vertex_t> PartitionedSolver::solveSegment(const std::vector<vertex_t> &segment, std::size_t numberOfTrials,
+                                                      std::mt19937::result_type segmentSeed) const {
+    const dimension_t size = segment.size();
+    if (size < 4) {
+        // The path between the fixed ends is unique
+        return segment;
+    }
+
+    // The path is closed to a tour by the edge {0, size - 1}, it stays fixed when the backbone is fixed
+    TsplibProblem subproblem = tsplibProblem.subproblem(segment);
+    CandidateEdges subproblemCandidateEdges = CandidateEdges::create(
+            subproblem, candidateEdgeType, std::min(numberOfCandidateEdges, size - 1));
+    LinKernighanHeuristic heuristic(subproblem, std::move(subproblemCandidateEdges), segmentSeed, parameters);
+    heuristic.fixEdge(0, size - 1);
+    Tour tour = heuristic.findBestTour(numberOfTrials, 0, 0, false);
+
+    // Merge the new path with the old one, both tours contain the fixed edge, so the merged tour contains it as well
+    std::vector<vertex_t> identity(size);
+    for (vertex_t v = 0; v < size; ++v) {
+        identity[v] = v;
+    }
+    Tour oldTour;
+    oldTour.setVertices(identity);
+    tour = mergeTours(subproblem, tour, oldTour, parameters.groupSize);
+    if (subproblem.length(tour) >= subproblem.length(oldTour)) {
+        return segment;
+    }
+
+    // Walk from the first vertex of the path away from the fixed edge to the last one
+    const bool forward = tour.successor(0) != size - 1;
+    std::vector<vertex_t> path;
+    path.reserve(size);
+    vertex_t v = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        path.push_back(segment[v]);
+        v = forward ? tour.successor(v) : tour.predecessor(v);
+    }
+    return path;
+}
+
+std::vector<vertex_t> PartitionedSolver::joinCellTours(const std::vector<std::vector<vertex_t>> &cellTours) const {
+    // Returns the position of the vertex in cellTour that is closest to v
+    auto closestPosition = [this](const std::vector<vertex_t> &cellTour, vertex_t v) {
+        std::size_t bestPosition = 0;
+        distance_t bestDistance = std::numeric_limits<distance_t>::max();
+        for (std::size_t position = 0; position < cellTour.size(); ++position) {
+            const distance_t distance = tsplibProblem.dist(v, cellTour[position]);
+            if (distance < bestDistance) {
+                bestPosition = position;
+                bestDistance = distance;
+            }
+        }
+        return bestPosition;
+    };
+
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(tsplibProblem.getDimension());
+    for (std::size_t c = 0; c < cellTours.size(); ++c) {
+        const std::vector<vertex_t> &cellTour = cellTours[c];
+        const std::size_t size = cellTour.size();
+        const std::size_t entry = tourSequence.empty() ? 0 : closestPosition(cellTour, tourSequence.back());
+
+        // The next vertex after the cell is the closest vertex of the next cell, or the first vertex of the tour
+        // after the last cell
+        const vertex_t next = c + 1 < cellTours.size()
+                              ? cellTours[c + 1][closestPosition(cellTours[c + 1], cellTour[entry])]
+                              : (tourSequence.empty() ? cellTour[entry] : tourSequence.front());
+        const vertex_t forwardExit = cellTour[(entry + size - 1) % size];
+        const vertex_t backwardExit = cellTour[(entry + 1) % size];
+        const bool forward = tsplibProblem.dist(forwardExit, next) <= tsplibProblem.dist(backwardExit, next);
+        for (std::size_t i = 0; i < size; ++i) {
+            tourSequence.push_back(cellTour[forward ? (entry + i) % size : (entry + size - i) % size]);
+        }
+    }
+    return tourSequence;
+}
+
+Tour PartitionedSolver::solve(dimension_t maxCellSize, std::size_t numberOfTrials, std::size_t numberOfThreads,
+                              bool verboseOutput) {
+    const std::vector<std::vector<vertex_t>> cells = tsplibProblem.partition(maxCellSize);
+    if (verboseOutput) std::cout << "Partitioned the problem into " << cells.size() << " cells" << std::endl;
+
+    std::vector<std::vector<vertex_t>> cellTours(cells.size());
+    {
+        ThreadPool threadPool(numberOfThreads);
+        threadPool.parallelFor(cells.size(), [&](std::size_t c) {
+            cellTours[c] = solveCell(cells[c], numberOfTrials, seed + static_cast<std::mt19937::result_type>(c));
+        });
+    }
+
+    Tour tour;
+    tour.setVertices(joinCellTours(cellTours), parameters.groupSize);
+    if (verboseOutput) std::cout << "Length of the joined tour: " << tsplibProblem.length(tour) << std::endl;
+
+    // The vertices with a candidate edge or a tour edge to another cell are searched
+    const dimension_t dimension = tsplibProblem.getDimension();
+    std::vector<std::size_t> cellOf(dimension);
+    for (std::size_t c = 0; c < cells.size(); ++c) {
+        for (vertex_t v : cells[c]) {
+            cellOf[v] = c;
+        }
+    }
+    std::vector<vertex_t> borderVertices;
+    for (vertex_t v = 0; v < dimension; ++v) {
+        bool isBorderVertex = cellOf[tour.predecessor(v)] != cellOf[v] or cellOf[tour.successor(v)] != cellOf[v];
+        for (const CandidateEdges::Edge &edge : candidateEdges[v]) {
+            isBorderVertex = isBorderVertex or cellOf[edge.vertex] != cellOf[v];
+        }
+        if (isBorderVertex) {
+            borderVertices.push_back(v);
+        }
+    }
+
+    // Only the joints and cuts need repairs, so the don't-look bits keep the search near the borders
+    LinKernighanHeuristic::Parameters borderParameters = parameters;
+    borderParameters.dontLookBits = true;
+    LinKernighanHeuristic heuristic(tsplibProblem, candidateEdges, seed, borderParameters);
+    tour = heuristic.improveTourFrom(tour, borderVertices);
+    if (verboseOutput) {
+        std::cout << "Length of the tour after searching from " << borderVertices.size() << " border vertices: "
+                  << tsplibProblem.length(tour) << std::endl;
+    }
+    return tour;
+}
+
+Tour PartitionedSolver::optimizeSegments(const Tour &tour, dimension_t segmentSize, std::size_t numberOfTrials,
+                                         std::size_t numberOfThreads, bool verboseOutput) {
+    const dimension_t dimension = tsplibProblem.getDimension();
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(dimension);
+    vertex_t v = 0;
+    do {
+        tourSequence.push_back(v);
+        v = tour.successor(v);
+    } while (v != 0);
+
+    ThreadPool threadPool(numberOfThreads);
+    const std::size_t numberOfSegments = (dimension + segmentSize - 1) / segmentSize;
+    for (std::size_t pass = 0; pass < 2; ++pass) {
+        // The segments of the second pass start in the middle of the segments of the first pass
+        const std::size_t offset = pass == 0 ? 0 : segmentSize / 2;
+        std::vector<std::vector<vertex_t>> segments(numberOfSegments);
+        for (std::size_t s = 0; s < numberOfSegments; ++s) {
+            for (std::size_t i = s * segmentSize; i < std::min((s + 1) * segmentSize, dimension); ++i) {
+                segments[s].push_back(tourSequence[(offset + i) % dimension]);
+            }
+        }
+        threadPool.parallelFor(numberOfSegments, [&](std::size_t s) {
+            const auto segmentSeed = seed + static_cast<std::mt19937::result_type>(pass * numberOfSegments + s);
+            segments[s] = solveSegment(segments[s], numberOfTrials, segmentSeed);
+        });
+
+        // Splice the paths back in, their ends are unchanged, so the result is a tour
+        for (std::size_t s = 0; s < numberOfSegments; ++s) {
+            for (std::size_t i = 0; i < segments[s].size(); ++i) {
+                tourSequence[(offset + s * segmentSize + i) % dimension] = segments[s][i];
+            }
+        }
+        if (verboseOutput) {
+            Tour passTour;
+            passTour.setVertices(tourSequence);
+            std::cout << "Length of the tour after pass " << pass + 1 << " of the segment optimization: "
+                      << tsplibProblem.length(passTour) << std::endl;
+        }
+    }
+
+    Tour optimizedTour;
+    optimizedTour.setVertices(tourSequence, parameters.groupSize);
+    return optimizedTour;
+}
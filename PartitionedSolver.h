@@ -0,0 +1,74 @@
+#ifndef LINKERNIGHANALGORITHM_PARTITIONEDSOLVER_H
+#define LINKERNIGHANALGORITHM_PARTITIONEDSOLVER_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// =========================================== PartitionedSolver class =================================================
+
+// This class solves large problems by partitioning the vertices into cells (see TsplibProblem::partition). Every cell
+// is solved as a subproblem of its own by a LinKernighanHeuristic with its own candidate edges and with don't-look
+// bits, the cells are solved in parallel. A trial of a cell takes about linear time in the size of the
+// cell, so the trials of all cells together cost about as much as one trial of the whole problem with don't-look bits.
+// The tours of the cells are joined in the order of the cells and afterwards only the vertices near the borders of the
+// cells are searched with the candidate edges of the whole problem and don't-look bits (see improveTourFrom), which
+// repairs the joints and the cuts through clusters of vertices.
+// Near-optimal tours of large problems can be improved in parallel in the same way by re-optimizing segments of the
+// tour (see optimizeSegments), while independent trials of the whole problem can not use more than one thread each.
+
+class PartitionedSolver {
+private:
+    TsplibProblem &tsplibProblem;
+
+    // The candidate edges of the whole problem
+    const CandidateEdges &candidateEdges;
+
+    // The candidate edges of the subproblems are created with these arguments (see CandidateEdges::create)
+    CandidateEdges::Type candidateEdgeType;
+    std::size_t numberOfCandidateEdges;
+
+    // The seed of the cell c is seed + c, so the result does not depend on the order in which the threads finish
+    std::mt19937::result_type seed;
+
+    LinKernighanHeuristic::Parameters parameters;
+
+    // Solves the subproblem of the vertices in cell with numberOfTrials trials and returns its vertices in the order of
+    // the tour
+    std::vector<vertex_t> solveCell(const std::vector<vertex_t> &cell, std::size_t numberOfTrials,
+                                    std::mt19937::result_type cellSeed) const;
+
+    // Re-optimizes the path through the vertices of segment (in this order) with numberOfTrials trials, the first and
+    // the last vertex stay the ends of the path. Returns the shorter one of the new and the old path
+    std::vector<vertex_t> solveSegment(const std::vector<vertex_t> &segment, std::size_t numberOfTrials,
+                                       std::mt19937::result_type segmentSeed) const;
+
+    // Joins the tours of the cells into one tour. Every cell tour is entered at the vertex closest to the end of the
+    // previous one and left at one of the two tour neighbors of that vertex, the one closer to the next cell
+    std::vector<vertex_t> joinCellTours(const std::vector<std::vector<vertex_t>> &cellTours) const;
+
+public:
+    PartitionedSolver() = delete;
+
+    // The problem and the candidate edges must outlive this object
+    PartitionedSolver(TsplibProblem &tsplibProblem, const CandidateEdges &candidateEdges,
+                      CandidateEdges::Type candidateEdgeType, std::size_t numberOfCandidateEdges,
+                      std::mt19937::result_type seed, LinKernighanHeuristic::Parameters parameters);
+
+    // Solve the problem with cells of at most maxCellSize vertices and numberOfTrials trials for every cell on
+    // numberOfThreads threads (0 means one for every hardware thread). verboseOutput turns debug output on or off
+    Tour solve(dimension_t maxCellSize, std::size_t numberOfTrials, std::size_t numberOfThreads,
+               bool verboseOutput = true);
+
+    // Improves tour by cutting it into disjoint segments of segmentSize consecutive vertices and re-optimizing the path
+    // of every segment between its two ends as a subproblem of its own (see solveSegment), the segments are solved in
+    // parallel. A second pass with segments shifted by half of segmentSize also improves the edges between the
+    // segments of the first pass. The result is never longer than tour. The other arguments are the same as for solve
+    Tour optimizeSegments(const Tour &tour, dimension_t segmentSize, std::size_t numberOfTrials,
+                          std::size_t numberOfThreads, bool verboseOutput = true);
+};
+
+#endif //LINKERNIGHANALGORITHM_PARTITIONEDSOLVER_H
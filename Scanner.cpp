@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "Scanner.h"
+
+Scanner::Scanner(const char *begin, const char *end) : position(begin), end(end) {}
+
+bool Scanner::atLetter() const {
+    return position != end and ((*position >= 'A' and *position <= 'Z') or (*position >= 'a' and *position <= 'z'));
+}
+
+std::string Scanner::readLine() {
+    const char *lineStart = position;
+    while (position != end and *position != '\n') {
+        ++position;
+    }
+    const char *lineEnd = position;
+    if (position != end) {
+        ++position; // Skip the line break
+    }
+    while (lineStart != lineEnd and isWhitespace(*lineStart)) {
+        ++lineStart;
+    }
+    while (lineEnd != lineStart and isWhitespace(*(lineEnd - 1))) {
+        --lineEnd;
+    }
+    return std::string(lineStart, lineEnd);
+}
+
+bool Scanner::parseDouble(double &value) {
+    // All powers of ten that can be represented exactly as a double
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                                         1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const std::uint64_t maxExactMantissa = std::uint64_t(1) << 53;
+    const std::uint64_t maxMantissa = 100000000000000000; // Further digits are only counted in the exponent
+
+    skipWhitespace();
+    const char *start = position;
+    bool negative = false;
+    if (position != end and (*position == '-' or *position == '+')) {
+        negative = *position == '-';
+        ++position;
+    }
+
+    std::uint64_t mantissa = 0;
+    long exponent = 0;
+    bool anyDigit = false;
+    while (position != end and static_cast<unsigned char>(*position - '0') <= 9) {
+        if (mantissa < maxMantissa) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*position - '0');
+        } else {
+            exponent++;
+        }
+        anyDigit = true;
+        ++position;
+    }
+    if (position != end and *position == '.') {
+        ++position;
+        while (position != end and static_cast<unsigned char>(*position - '0') <= 9) {
+            if (mantissa < maxMantissa) {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(*position - '0');
+                exponent--;
+            }
+            anyDigit = true;
+            ++position;
+        }
+    }
+    if (anyDigit and position != end and (*position == 'e' or *position == 'E')) {
+        ++position;
+        bool negativeExponent = false;
+        if (position != end and (*position == '-' or *position == '+')) {
+            negativeExponent = *position == '-';
+            ++position;
+        }
+        long explicitExponent = 0;
+        const char *exponentStart = position;
+        while (position != end and static_cast<unsigned char>(*position - '0') <= 9) {
+            if (explicitExponent < 100000) {
+                explicitExponent = explicitExponent * 10 + (*position - '0');
+            }
+            ++position;
+        }
+        if (position == exponentStart) {
+            anyDigit = false; // An exponent without digits is invalid
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (!anyDigit or !atDelimiter()) {
+        position = start;
+        return false;
+    }
+
+    if (mantissa <= maxExactMantissa and exponent >= -22 and exponent <= 22) {
+        // The mantissa and the power of ten are exact, so a single multiplication or division is correctly rounded
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+        value = negative ? -result : result;
+    } else {
+        // Rare case with too many significant digits or a large exponent, strtod needs a null-terminated string
+        const std::string number(start, position);
+        value = std::strtod(number.c_str(), nullptr);
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef LINKERNIGHANALGORITHM_SCANNER_H
+#define LINKERNIGHANALGORITHM_SCANNER_H
+
+#include <string>
+
+// ================================================== Scanner class ====================================================
+
+// This class splits a range of characters (that does not have to be null-terminated) into lines and numbers. It is used
+// to parse TSPLIB files without copying every line into a string first.
+// All parse functions skip whitespaces (including line breaks) before the number and only accept the number if it is
+// followed by a whitespace or the end of the range. If they return false, the position is not changed.
+
+class Scanner {
+private:
+    const char *position;
+    const char *const end;
+
+    // Returns whether c is a whitespace, line breaks included
+    static bool isWhitespace(char c) {
+        return c == ' ' or c == '\n' or c == '\t' or c == '\r' or c == '\v' or c == '\f';
+    }
+
+    // Returns whether the position is at the end of a number, i.e. at a whitespace or the end of the range
+    bool atDelimiter() const {
+        return position == end or isWhitespace(*position);
+    }
+
+public:
+    Scanner(const char *begin, const char *end);
+
+    // Returns whether all characters have been read
+    bool atEnd() const {
+        return position == end;
+    }
+
+    // Returns whether the next character is a letter (A-Z, a-z)
+    bool atLetter() const;
+
+    // Skip all whitespaces including line breaks
+    void skipWhitespace() {
+        while (position != end and isWhitespace(*position)) {
+            ++position;
+        }
+    }
+
+    // Returns the rest of the current line without whitespaces at the start and the end and moves to the next line
+    std::string readLine();
+
+    // Parse a non-negative decimal integer
+    template<typename Unsigned>
+    bool parseUnsigned(Unsigned &value) {
+        skipWhitespace();
+        const char *start = position;
+        Unsigned result = 0;
+        while (position != end and static_cast<unsigned char>(*position - '0') <= 9) {
+            result = result * 10 + static_cast<Unsigned>(*position - '0');
+            ++position;
+        }
+        if (position == start or !atDelimiter()) {
+            position = start;
+            return false;
+        }
+        value = result;
+        return true;
+    }
+
+    // Parse a decimal floating point number with optional sign, fraction and exponent (e.g. -1.5e+03)
+    bool parseDouble(double &value);
+};
+
+#endif //LINKERNIGHANALGORITHM_SCANNER_H
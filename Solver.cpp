@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <istream>
+#include <string>
+#include <utility>
+#include "HeldKarp.h"
+#include "LinKernighanHeuristic.h"
+#include "MappedFile.h"
+#include "MemoryPlan.h"
+#include "MultilevelSolver.h"
+#include "PartitionedSolver.h"
+#include "Solver.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ================================================ Solver pipeline ====================================================
+
+std::string SolverOptions::readOption(const std::string &option, std::istream &valueStream) {
+    if (option == "--number-of-trials") {
+        valueStream >> numberOfTrials;
+    } else if (option == "--candidate-edges") {
+        std::string type;
+        std::getline(valueStream, type);
+        if (type == "ALL") {
+            candidateEdgeType = CandidateEdges::ALL_NEIGHBORS;
+        } else if (type == "NEAREST") {
+            candidateEdgeType = CandidateEdges::NEAREST_NEIGHBORS;
+        } else if (type == "ALPHA_NEAREST") {
+            candidateEdgeType = CandidateEdges::ALPHA_NEAREST_NEIGHBORS;
+        } else if (type == "OPT_ALPHA_NEAREST") {
+            candidateEdgeType = CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS;
+        } else {
+            return "The --candidate-edges type '" + type + "' is not valid";
+        }
+    } else if (option == "--number-of-candidate-edges") {
+        valueStream >> numberOfCandidateEdges;
+    } else if (option == "--dont-store-distances") {
+        storeAllDistances = false;
+    } else if (option == "--distance-cache-mb") {
+        valueStream >> distanceCacheMegabytes;
+        storeAllDistances = false;
+    } else if (option == "--memory-limit") {
+        valueStream >> memoryLimitMegabytes;
+    } else if (option == "--renumber-vertices") {
+        renumberVertices = true;
+    } else if (option == "--merge-duplicates") {
+        mergeDuplicates = true;
+    } else if (option == "--mode") {
+        std::string mode;
+        std::getline(valueStream, mode);
+        if (mode == "LK") {
+            parameters.searchMode = LinKernighanHeuristic::LK_MODE;
+        } else if (mode == "FAST") {
+            parameters.searchMode = LinKernighanHeuristic::FAST_MODE;
+        } else if (mode == "FAST_LK") {
+            parameters.searchMode = LinKernighanHeuristic::FAST_LK_MODE;
+        } else {
+            return "The --mode '" + mode + "' is not valid";
+        }
+    } else if (option == "--move-type") {
+        std::string type;
+        std::getline(valueStream, type);
+        if (type == "LK") {
+            parameters.moveType = LinKernighanHeuristic::LK_MOVE;
+        } else if (type == "5OPT") {
+            parameters.moveType = LinKernighanHeuristic::FIVE_OPT_MOVE;
+        } else {
+            return "The --move-type '" + type + "' is not valid";
+        }
+    } else if (option == "--backtracking-depth") {
+        valueStream >> parameters.backtrackingDepth;
+    } else if (option == "--infeasibility-depth") {
+        valueStream >> parameters.infeasibilityDepth;
+    } else if (option == "--max-move-depth") {
+        valueStream >> parameters.maxMoveDepth;
+        if (!valueStream.fail() and parameters.maxMoveDepth == 1) {
+            return "The --max-move-depth must be 0 or at least 2";
+        }
+    } else if (option == "--group-size") {
+        valueStream >> parameters.groupSize;
+    } else if (option == "--tour-merging") {
+        parameters.tourMerging = true;
+    } else if (option == "--backbone-tours") {
+        valueStream >> parameters.backboneSize;
+    } else if (option == "--fix-backbone") {
+        parameters.fixBackbone = true;
+    } else if (option == "--dont-look-bits") {
+        parameters.dontLookBits = true;
+    } else if (option == "--partition-size") {
+        valueStream >> partitionSize;
+    } else if (option == "--multilevel") {
+        valueStream >> coarsestSize;
+    } else if (option == "--segment-size") {
+        valueStream >> segmentSize;
+    } else if (option == "--window-size") {
+        valueStream >> windowSize;
+        if (!valueStream.fail() and windowSize != 0 and (windowSize < 4 or windowSize > MAX_WINDOW_SIZE)) {
+            return "The --window-size must be between 4 and " + std::to_string(MAX_WINDOW_SIZE);
+        }
+    } else if (option == "--threads") {
+        valueStream >> numberOfThreads;
+    } else if (option == "--candidate-order") {
+        std::string order;
+        std::getline(valueStream, order);
+        if (order == "REVERSE_ALPHA") {
+            parameters.candidateOrder = LinKernighanHeuristic::REVERSE_ALPHA_ORDER;
+        } else if (order == "ALPHA") {
+            parameters.candidateOrder = LinKernighanHeuristic::ALPHA_ORDER;
+        } else if (order == "LOOKAHEAD") {
+            parameters.candidateOrder = LinKernighanHeuristic::LOOKAHEAD_ORDER;
+        } else {
+            return "The --candidate-order '" + order + "' is not valid";
+        }
+    } else if (option == "--breadth") {
+        parameters.breadth.clear();
+        std::size_t breadth;
+        while (valueStream >> breadth) {
+            if (breadth == 0) {
+                return "The --breadth values must be at least 1";
+            }
+            parameters.breadth.push_back(breadth);
+            valueStream.ignore(1, ',');
+        }
+        valueStream.clear();
+    } else if (option == "--acceptable-error") {
+        valueStream >> acceptableError;
+    } else {
+        return "The option '" + option + "' is unknown";
+    }
+    if (valueStream.fail()) {
+        return "The option '" + option + "' has an invalid format";
+    }
+    return "";
+}
+
+std::string SolverOptions::validate() const {
+    if (partitionSize != 0 and candidateEdgeType == CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS) {
+        return "The --partition-size can not be used with --candidate-edges=OPT_ALPHA_NEAREST, the subgradient "
+               "optimization of every cell would take longer than its search";
+    }
+    return "";
+}
+
+namespace {
+    // With a memory limit, renumbered or merged vertices, partitioning or the multi-level approach the distances are
+    // only stored after the problem was read, because the memory plan and the solver choice need the dimension and the
+    // renumbering and merging change all distances
+    bool deferDistances(const SolverOptions &options) {
+        return options.memoryLimitMegabytes != 0 or options.renumberVertices or options.mergeDuplicates or
+               options.partitionSize != 0 or options.coarsestSize != 0;
+    }
+}
+
+std::string readProblem(const std::string &fileName, const SolverOptions &options, TsplibProblem &problem) {
+    // The file is mapped into memory to read it as fast as possible
+    MappedFile problemFile;
+    std::string errorMessage = problemFile.open(fileName);
+    if (!errorMessage.empty()) {
+        return "Could not open the TSPLIB file: " + errorMessage;
+    }
+
+    problem = TsplibProblem(options.storeAllDistances and !deferDistances(options),
+                            options.distanceCacheMegabytes * 1024 * 1024);
+    if (TsplibProblem::isBinaryFile(problemFile)) {
+        errorMessage = problem.readBinaryFile(std::move(problemFile));
+    } else {
+        errorMessage = problem.readFile(problemFile);
+    }
+    if (!errorMessage.empty()) {
+        return "The TSPLIB file '" + fileName + "' has an invalid format: " + errorMessage;
+    }
+    return "";
+}
+
+SolverResult solve(TsplibProblem &problem, const SolverOptions &options, bool verboseOutput) {
+    if (options.mergeDuplicates) {
+        const dimension_t mergedVertices = problem.mergeDuplicates(
+                std::max<dimension_t>(3, options.numberOfCandidateEdges + 1));
+        if (verboseOutput) std::cout << "Merged " << mergedVertices << " duplicate vertices" << std::endl;
+    }
+
+    if (options.renumberVertices) {
+        problem.renumber(problem.localityOrder());
+        if (verboseOutput) std::cout << "Renumbered the vertices" << std::endl;
+    }
+
+    // The partitioned solver only uses the candidate edges of the whole problem to find the vertices at the borders of
+    // the cells and to search from them, the multi-level solver to match the vertices and to repair the expanded tour.
+    // So they are the nearest neighbors found with a grid and the distances are not stored in a matrix. Both the
+    // matrix and the other candidate edges need quadratic time
+    const dimension_t dimension = problem.getDimension();
+    const bool sparseCandidateEdges = dimension > MAX_EXACT_DIMENSION and
+                                      ((options.partitionSize != 0 and dimension > options.partitionSize) or
+                                       (options.coarsestSize != 0 and dimension > options.coarsestSize));
+
+    MemoryPlan memoryPlan;
+    if (options.memoryLimitMegabytes != 0) {
+        memoryPlan = MemoryPlan::create(problem, options.candidateEdgeType, options.numberOfCandidateEdges,
+                                        options.memoryLimitMegabytes * 1024 * 1024, sparseCandidateEdges);
+        if (verboseOutput) std::cout << memoryPlan.toString() << std::flush;
+        if (!memoryPlan.isWithinLimit()) {
+            std::cerr << "The memory limit is too low for the problem, the plan with the least memory usage is used"
+                      << std::endl;
+        }
+        memoryPlan.apply(problem);
+    } else if (deferDistances(options)) {
+        problem.setDistanceStorage(options.storeAllDistances and !sparseCandidateEdges,
+                                   options.distanceCacheMegabytes * 1024 * 1024, false);
+    }
+
+    CandidateEdges candidateEdges = sparseCandidateEdges
+                                    ? CandidateEdges::sparseNearestNeighbors(problem, options.numberOfCandidateEdges)
+                                    : CandidateEdges::create(problem, options.candidateEdgeType,
+                                                             options.numberOfCandidateEdges,
+                                                             memoryPlan.useStreamingAlpha());
+    if (verboseOutput) std::cout << "Computed candidate edges" << std::endl;
+
+    SolverResult result;
+    result.searchStartTime = std::chrono::steady_clock::now();
+    if (dimension <= MAX_EXACT_DIMENSION) {
+        result.tour = solveExactly(problem, options.parameters.groupSize);
+        if (verboseOutput) std::cout << "Solved the problem exactly by dynamic programming" << std::endl;
+    } else if (options.partitionSize != 0 and dimension > options.partitionSize) {
+        PartitionedSolver solver(problem, candidateEdges, options.candidateEdgeType, options.numberOfCandidateEdges,
+                                 options.seed, options.parameters);
+        result.tour = solver.solve(options.partitionSize, options.numberOfTrials, options.numberOfThreads,
+                                   verboseOutput);
+    } else if (options.coarsestSize != 0 and dimension > options.coarsestSize) {
+        MultilevelSolver solver(problem, candidateEdges, options.candidateEdgeType, options.numberOfCandidateEdges,
+                                options.seed, options.parameters);
+        result.tour = solver.solve(std::max<dimension_t>(options.coarsestSize, 3), options.numberOfTrials,
+                                   verboseOutput);
+    } else {
+        LinKernighanHeuristic heuristic(problem, candidateEdges, options.seed, options.parameters);
+        result.tour = heuristic.findBestTour(options.numberOfTrials, options.optimumTourLength,
+                                             options.acceptableError / 100, verboseOutput);
+        result.improvements = heuristic.getImprovements();
+        result.duplicateTrials = heuristic.getDuplicateTrials();
+        if (verboseOutput) {
+            std::cout << "Trials that found the tour of an earlier trial: " << result.duplicateTrials << std::endl;
+        }
+    }
+    if (options.segmentSize != 0 and dimension > options.segmentSize) {
+        PartitionedSolver solver(problem, candidateEdges, options.candidateEdgeType, options.numberOfCandidateEdges,
+                                 options.seed, options.parameters);
+        result.tour = solver.optimizeSegments(result.tour, options.segmentSize, options.numberOfTrials,
+                                              options.numberOfThreads, verboseOutput);
+    }
+    if (options.windowSize != 0) {
+        result.tour = optimizeWindows(problem, result.tour, options.windowSize, options.parameters.groupSize);
+        if (verboseOutput) std::cout << "Length of the tour after the window optimization: "
+                                     << problem.length(result.tour) << std::endl;
+    }
+    return result;
+}
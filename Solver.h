@@ -0,0 +1,79 @@
+#ifndef LINKERNIGHANALGORITHM_SOLVER_H
+#define LINKERNIGHANALGORITHM_SOLVER_H
+
+#include <chrono>
+#include <cstddef>
+#include <istream>
+#include <random>
+#include <string>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ================================================ Solver pipeline ====================================================
+
+// LinKernighanAlgorithm and LinKernighanBenchmark solve a problem file in the same way: the problem is read, its
+// vertices are merged and renumbered if requested, the distances are stored as the options or the memory plan say, the
+// candidate edges are computed and the exact, partitioned, multi-level or LK solver finds a tour that is improved by the
+// segment and window optimizations. Both programs read the options of this pipeline with SolverOptions::readOption.
+
+// The options of the pipeline, the defaults are the defaults of LinKernighanAlgorithm
+struct SolverOptions {
+    std::size_t numberOfTrials = 50;
+    CandidateEdges::Type candidateEdgeType = CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS;
+    std::size_t numberOfCandidateEdges = 5;
+    bool storeAllDistances = true;
+    std::size_t distanceCacheMegabytes = 0;
+    std::size_t memoryLimitMegabytes = 0;
+    bool renumberVertices = false;
+    bool mergeDuplicates = false;
+    LinKernighanHeuristic::Parameters parameters;
+    dimension_t partitionSize = 0;
+    dimension_t coarsestSize = 0;
+    dimension_t segmentSize = 0;
+    std::size_t windowSize = 0;
+    std::size_t numberOfThreads = 0;
+
+    // The LK solver stops when it found a tour whose length is at most acceptableError percent above
+    // optimumTourLength, 0 means that the optimum is not known
+    double acceptableError = 0;
+
+    // readOption does not read --optimum-tour-length and --seed, LinKernighanBenchmark sets them for every run
+    distance_t optimumTourLength = 0;
+    std::mt19937::result_type seed = 1;
+
+    // Reads the option with the name option (e.g. "--number-of-trials"), its value is the rest of valueStream
+    // Returns an error message if the option is unknown or its value is invalid and an empty string otherwise
+    std::string readOption(const std::string &option, std::istream &valueStream);
+
+    // Checks the options that can not be used together, must be called after all options were read
+    // Returns an error message if some options conflict and an empty string otherwise
+    std::string validate() const;
+};
+
+// Reads the TSPLIB file or binary problem file fileName into problem. The distances are stored right away only if the
+// options need no later decision about them (see solve), a binary file keeps its mapping alive if it contains the
+// distance matrix
+// Returns an error message if an error occurred and an empty string otherwise
+std::string readProblem(const std::string &fileName, const SolverOptions &options, TsplibProblem &problem);
+
+// The result of solve
+struct SolverResult {
+    Tour tour;
+
+    // The time when the candidate edges were computed and the search started
+    std::chrono::steady_clock::time_point searchStartTime;
+
+    // The improvements of the best tour and the number of duplicate trials if the LK solver was used (see
+    // LinKernighanHeuristic::getImprovements and getDuplicateTrials), otherwise empty and 0
+    std::vector<LinKernighanHeuristic::Improvement> improvements;
+    std::size_t duplicateTrials = 0;
+};
+
+// Solves problem, which was read by readProblem with the same options, by the pipeline described at the top of this
+// file. Merging and renumbering change the vertices of problem (see TsplibProblem::originalTour). verboseOutput turns
+// the progress output on or off
+SolverResult solve(TsplibProblem &problem, const SolverOptions &options, bool verboseOutput);
+
+#endif //LINKERNIGHANALGORITHM_SOLVER_H
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Statistics.h"
+
+namespace {
+    // The names used in the JSON output, in the same order as the enums in Statistics.h
+    const char *const counterNames[] = {"dist_calls", "is_between_calls", "is_tour_after_exchange_calls", "flips",
+                                        "flip_reversed_length", "subgradient_iterations", "distance_cache_hits",
+                                        "distance_cache_misses"};
+    const char *const levelCounterNames[] = {"backtracks_per_level", "improving_moves_per_depth"};
+    const char *const phaseNames[] = {"parsing", "matrix_fill", "subgradient_optimization", "alpha_computation",
+                                      "candidate_sorting", "tour_construction", "lk_search", "tour_merging"};
+
+    // The counters of all running threads and the sums of the counters of the threads that already ended
+    struct CounterRegistry {
+        std::mutex mutex;
+        std::vector<Statistics::ThreadCounters *> threads;
+        unsigned long long endedCounters[Statistics::NUMBER_OF_COUNTERS] = {};
+        unsigned long long endedLevelCounters[Statistics::NUMBER_OF_LEVEL_COUNTERS][Statistics::MAX_LEVEL] = {};
+    };
+
+    // The registry is created on first use, so that threads may count during the initialization of static variables
+    CounterRegistry &counterRegistry() {
+        static CounterRegistry registry;
+        return registry;
+    }
+
+    // Variables with static storage duration are zero-initialized
+    std::atomic<unsigned long long> phaseNanoseconds[Statistics::NUMBER_OF_PHASES];
+    std::atomic<unsigned long long> phaseCalls[Statistics::NUMBER_OF_PHASES];
+
+    // The number of ScopedTimers of each phase that currently exist in this thread. Only the outermost one measures
+    // the time, so that recursive functions are not counted multiple times
+    thread_local unsigned int timerDepth[Statistics::NUMBER_OF_PHASES];
+}
+
+bool Statistics::isEnabled() {
+#ifdef LK_STATISTICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+Statistics::ThreadCounters::ThreadCounters() {
+    for (auto &counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto &levels : levelCounters) {
+        for (auto &counter : levels) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+Statistics::ThreadCounters::~ThreadCounters() {
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (std::size_t counter = 0; counter < NUMBER_OF_COUNTERS; ++counter) {
+        registry.endedCounters[counter] += counters[counter].load(std::memory_order_relaxed);
+    }
+    for (std::size_t counter = 0; counter < NUMBER_OF_LEVEL_COUNTERS; ++counter) {
+        for (std::size_t level = 0; level < MAX_LEVEL; ++level) {
+            const unsigned long long value = levelCounters[counter][level].load(std::memory_order_relaxed);
+            registry.endedLevelCounters[counter][level] += value;
+        }
+    }
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+namespace {
+    // Returns the value of a level counter summed over all threads
+    unsigned long long getLevelCount(Statistics::LevelCounter counter, std::size_t level) {
+        CounterRegistry &registry = counterRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        unsigned long long sum = registry.endedLevelCounters[counter][level];
+        for (const Statistics::ThreadCounters *thread : registry.threads) {
+            sum += thread->levelCounters[counter][level].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+}
+
+void Statistics::reset() {
+    // The counters of the running threads are only set to zero by another thread if they do not count at the same
+    // time, which is the case between two runs of the algorithm
+    CounterRegistry &registry = counterRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (ThreadCounters *thread : registry.threads) {
+            for (auto &counter : thread->counters) {
+                counter.store(0, std::memory_order_relaxed);
+            }
+            for (auto &levels : thread->levelCounters) {
+                for (auto &counter : levels) {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        for (auto &counter : registry.endedCounters) {
+            counter = 0;
+        }
+        for (auto &levels : registry.endedLevelCounters) {
+            for (auto &counter : levels) {
+                counter = 0;
+            }
+        }
+    }
+    for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+        phaseNanoseconds[phase].store(0, std::memory_order_relaxed);
+        phaseCalls[phase].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Statistics::addTime(Phase phase, std::chrono::nanoseconds duration) {
+    phaseNanoseconds[phase].fetch_add(static_cast<unsigned long long>(duration.count()), std::memory_order_relaxed);
+    phaseCalls[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long long Statistics::getCount(Counter counter) {
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    unsigned long long sum = registry.endedCounters[counter];
+    for (const ThreadCounters *thread : registry.threads) {
+        sum += thread->counters[counter].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+double Statistics::getSeconds(Phase phase) {
+    return phaseNanoseconds[phase].load(std::memory_order_relaxed) / 1e9;
+}
+
+const char *Statistics::getName(Phase phase) {
+    return phaseNames[phase];
+}
+
+std::string Statistics::toJson() {
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"enabled\": " << (isEnabled() ? "true" : "false") << ",\n";
+
+    json << "  \"counters\": {";
+    for (std::size_t counter = 0; counter < NUMBER_OF_COUNTERS; ++counter) {
+        json << (counter == 0 ? "\n" : ",\n") << "    \"" << counterNames[counter] << "\": "
+             << getCount(static_cast<Counter>(counter));
+    }
+    json << "\n  },\n";
+
+    // Only output the levels up to the last one with a non-zero value
+    for (std::size_t counter = 0; counter < NUMBER_OF_LEVEL_COUNTERS; ++counter) {
+        std::size_t numberOfLevels = MAX_LEVEL;
+        unsigned long long levelCounts[MAX_LEVEL];
+        for (std::size_t level = 0; level < MAX_LEVEL; ++level) {
+            levelCounts[level] = getLevelCount(static_cast<LevelCounter>(counter), level);
+        }
+        while (numberOfLevels > 0 and levelCounts[numberOfLevels - 1] == 0) {
+            numberOfLevels--;
+        }
+        json << "  \"" << levelCounterNames[counter] << "\": [";
+        for (std::size_t level = 0; level < numberOfLevels; ++level) {
+            json << (level == 0 ? "" : ", ") << levelCounts[level];
+        }
+        json << "],\n";
+    }
+
+    json << "  \"phases\": {";
+    for (std::size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+        json << (phase == 0 ? "\n" : ",\n") << "    \"" << phaseNames[phase] << "\": {\"seconds\": "
+             << getSeconds(static_cast<Phase>(phase)) << ", \"calls\": "
+             << phaseCalls[phase].load(std::memory_order_relaxed) << "}";
+    }
+    json << "\n  }\n";
+    json << "}\n";
+    return json.str();
+}
+
+Statistics::ScopedTimer::ScopedTimer(Phase phase) : phase(phase) {
+    if (timerDepth[phase]++ == 0) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Statistics::ScopedTimer::~ScopedTimer() {
+    if (--timerDepth[phase] == 0) {
+        addTime(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+    }
+}
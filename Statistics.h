@@ -0,0 +1,130 @@
+#ifndef LINKERNIGHANALGORITHM_STATISTICS_H
+#define LINKERNIGHANALGORITHM_STATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// This namespace collects counters and running times of the different phases of the algorithm. Every thread increases
+// its own counters, which are summed when they are read, so counting needs no synchronization between the threads. The
+// running times are stored in shared atomic variables, because the phases are only entered a few times.
+
+// The instrumentation is only compiled in when the CMake option LK_STATISTICS is turned on (this defines the macro
+// LK_STATISTICS). The code of the algorithm only uses the STATISTICS_* macros at the bottom of this file, which expand
+// to nothing otherwise, so there is no overhead at all in a normal build. The macro LK_PHASE_TIMERS compiles in only
+// the timers of the phases, which LinKernighanBenchmark uses to measure the phases of an otherwise normal build.
+
+namespace Statistics {
+    // Counters for single operations
+    enum Counter {
+        DIST_CALLS, IS_BETWEEN_CALLS, IS_TOUR_AFTER_EXCHANGE_CALLS, FLIPS, FLIP_REVERSED_LENGTH, SUBGRADIENT_ITERATIONS,
+        DISTANCE_CACHE_HITS, DISTANCE_CACHE_MISSES, NUMBER_OF_COUNTERS
+    };
+
+    // Counters that are kept separately for every level (or depth) of the Lin-Kernighan search
+    enum LevelCounter {
+        BACKTRACKS, IMPROVING_MOVES, NUMBER_OF_LEVEL_COUNTERS
+    };
+
+    // The phases of the algorithm whose running time is measured. Phases may be nested (e.g. SUBGRADIENT_OPTIMIZATION
+    // inside of ALPHA_COMPUTATION), the time of a phase always includes the time of all phases nested inside of it.
+    // Single operations like flips are only counted, because measuring their time would take longer than the operation
+    enum Phase {
+        PARSING, MATRIX_FILL, SUBGRADIENT_OPTIMIZATION, ALPHA_COMPUTATION, CANDIDATE_SORTING, TOUR_CONSTRUCTION,
+        LK_SEARCH, TOUR_MERGING, NUMBER_OF_PHASES
+    };
+
+    // Levels greater or equal to MAX_LEVEL are counted as MAX_LEVEL - 1
+    const std::size_t MAX_LEVEL = 64;
+
+    // Returns whether the instrumentation was compiled in, the phase timers alone (LK_PHASE_TIMERS) do not count
+    bool isEnabled();
+
+    // Sets all counters and times to zero
+    void reset();
+
+    // The counters of a single thread. Only the thread itself increases them, the atomic variables just allow other
+    // threads to read them at the same time. When the thread ends its counters are added to those of the ended threads
+    struct ThreadCounters {
+        std::atomic<unsigned long long> counters[NUMBER_OF_COUNTERS];
+        std::atomic<unsigned long long> levelCounters[NUMBER_OF_LEVEL_COUNTERS][MAX_LEVEL];
+
+        ThreadCounters();
+
+        ThreadCounters(const ThreadCounters &) = delete;
+
+        ThreadCounters &operator=(const ThreadCounters &) = delete;
+
+        ~ThreadCounters();
+    };
+
+    // Returns the counters of the current thread
+    inline ThreadCounters &threadCounters() {
+        static thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    // Increases counter by amount
+    inline void count(Counter counter, unsigned long long amount = 1) {
+        std::atomic<unsigned long long> &value = threadCounters().counters[counter];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Increases the counter for level by one
+    inline void countAtLevel(LevelCounter counter, std::size_t level) {
+        const std::size_t index = level < MAX_LEVEL ? level : MAX_LEVEL - 1;
+        std::atomic<unsigned long long> &value = threadCounters().levelCounters[counter][index];
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Adds duration to the total running time of phase and increases the number of times phase was entered
+    void addTime(Phase phase, std::chrono::nanoseconds duration);
+
+    // Returns the current value of counter, the sum over all threads
+    unsigned long long getCount(Counter counter);
+
+    // Returns the total running time of phase in seconds
+    double getSeconds(Phase phase);
+
+    // Returns the name of phase as used in the JSON output
+    const char *getName(Phase phase);
+
+    // Returns all collected values as a JSON object
+    std::string toJson();
+
+    // Measures the time from its construction to its destruction and adds it to phase. If there already is a
+    // ScopedTimer for the same phase in the current thread (e.g. in a recursive function) nothing is measured.
+    class ScopedTimer {
+    private:
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedTimer(Phase phase);
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer();
+    };
+}
+
+#ifdef LK_STATISTICS
+#define STATISTICS_COUNT(counter) Statistics::count(Statistics::counter)
+#define STATISTICS_ADD(counter, amount) Statistics::count(Statistics::counter, (amount))
+#define STATISTICS_COUNT_AT_LEVEL(counter, level) Statistics::countAtLevel(Statistics::counter, (level))
+#else
+#define STATISTICS_COUNT(counter) ((void) 0)
+#define STATISTICS_ADD(counter, amount) ((void) 0)
+#define STATISTICS_COUNT_AT_LEVEL(counter, level) ((void) 0)
+#endif
+
+#if defined(LK_STATISTICS) || defined(LK_PHASE_TIMERS)
+#define STATISTICS_TIMER(phase) Statistics::ScopedTimer statisticsTimer##phase(Statistics::phase)
+#else
+#define STATISTICS_TIMER(phase) ((void) 0)
+#endif
+
+#endif //LINKERNIGHANALGORITHM_STATISTICS_H
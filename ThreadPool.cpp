@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "ThreadPool.h"
+
+// ============================================== ThreadPool class =====================================================
+
+thread_local std::size_t ThreadPool::taskDepth = 0;
+
+ThreadPool::ThreadPool(std::size_t numberOfThreads) {
+    if (numberOfThreads == 0) {
+        // hardware_concurrency returns 0 if the number is unknown
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (std::size_t i = 0; i < numberOfThreads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping or !tasks.empty(); });
+            if (tasks.empty()) {
+                return; // stopping is true and all tasks are finished
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        ++taskDepth;
+        task();
+        --taskDepth;
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+bool ThreadPool::isInsideTask() {
+    return taskDepth > 0;
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+    // std::function needs a copyable function, so the packaged_task is shared
+    auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> result = packagedTask->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace([packagedTask]() { (*packagedTask)(); });
+    }
+    taskAvailable.notify_one();
+    return result;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+
+    // The state is shared with the helper tasks, because a helper may only start after all indices are finished
+    struct LoopState {
+        std::function<void(std::size_t)> body;
+        std::size_t count;
+        std::atomic<std::size_t> nextIndex{0};
+        std::mutex mutex;
+        std::condition_variable finishedCondition;
+        std::size_t finished = 0;
+        std::exception_ptr exception;
+    };
+    auto state = std::make_shared<LoopState>();
+    state->body = body;
+    state->count = count;
+
+    auto runLoop = [state]() {
+        std::size_t index;
+        while ((index = state->nextIndex++) < state->count) {
+            std::exception_ptr exception;
+            ++taskDepth;
+            try {
+                state->body(index);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            --taskDepth;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (exception and !state->exception) {
+                state->exception = exception;
+            }
+            if (++state->finished == state->count) {
+                state->finishedCondition.notify_all();
+            }
+        }
+    };
+
+    // The calling thread works as well, so at most count - 1 helpers are useful
+    const std::size_t numberOfHelpers = std::min(workers.size(), count - 1);
+    for (std::size_t i = 0; i < numberOfHelpers; ++i) {
+        submit(runLoop);
+    }
+    runLoop();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finishedCondition.wait(lock, [&state]() { return state->finished == state->count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef LINKERNIGHANALGORITHM_THREADPOOL_H
+#define LINKERNIGHANALGORITHM_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// ============================================== ThreadPool class =====================================================
+
+// This class starts a fixed number of worker threads that execute the submitted tasks in the order of submission.
+// parallelFor distributes the indices of a loop dynamically over the worker threads and the calling thread, so it may
+// also be called from inside a task without waiting for a free worker.
+
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    // The tasks that were not yet started, protected by mutex
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+
+    // Set by the destructor, the workers finish the remaining tasks and stop
+    bool stopping = false;
+
+    // The loop of every worker thread
+    void work();
+
+    // The number of tasks and loop bodies of any ThreadPool that the current thread is executing (see isInsideTask)
+    static thread_local std::size_t taskDepth;
+
+public:
+    // Start numberOfThreads worker threads, 0 starts one thread for every hardware thread
+    explicit ThreadPool(std::size_t numberOfThreads = 0);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Waits until all submitted tasks are finished and stops the worker threads
+    ~ThreadPool();
+
+    // Returns the number of worker threads
+    std::size_t size() const;
+
+    // Execute task on one of the worker threads, the future becomes ready when the task is finished and rethrows the
+    // exception of the task
+    std::future<void> submit(std::function<void()> task);
+
+    // Call body(index) for every index in [0, count) and return when all calls are finished. The calls are executed
+    // on the worker threads and the calling thread, so body must be safe to call concurrently for different indices.
+    // If a call throws an exception, the remaining indices are still processed and the first exception is rethrown
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &body);
+
+    // Returns whether the current thread executes a task or a body of parallelFor of any ThreadPool. Code that may run
+    // inside such a task should not start a pool of its own, the threads of the outer pool are already busy
+    static bool isInsideTask();
+};
+
+#endif //LINKERNIGHANALGORITHM_THREADPOOL_H
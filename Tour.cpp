@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <list>
@@ -12,6 +13,8 @@
 #include <vector>
 #include "Tour.h"
 #include "SignedPermutation.h"
+#include "Statistics.h"
+#include "TourTrace.h"
 
 
 // ============================================= AlternatingWalk class =================================================
@@ -71,6 +74,69 @@ bool AlternatingWalk::containsEdge(vertex_t v, vertex_t w) const {
 
 // ================================================= BaseTour class ====================================================
 
+void BaseTour::resetHash(const std::vector<vertex_t> &tourSequence) {
+    discardCheckpoint();
+    hash = 0;
+    for (std::size_t i = 0; i < tourSequence.size(); ++i) {
+        hash ^= edgeKey(tourSequence[i], tourSequence[(i + 1) % tourSequence.size()]);
+    }
+}
+
+void BaseTour::recordFlip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
+    hash ^= edgeKey(a, b) ^ edgeKey(c, d) ^ edgeKey(b, c) ^ edgeKey(d, a);
+    if (hasCheckpoint) {
+        journal.push_back({a, b, c, d});
+    }
+}
+
+std::uint64_t BaseTour::edgeKey(vertex_t vertex1, vertex_t vertex2) {
+    // The finalizer of SplitMix64 applied to the ordered pair of vertices. It does not need a table of random numbers,
+    // so the keys are the same for all tours of all dimensions
+    std::uint64_t key = (static_cast<std::uint64_t>(std::min(vertex1, vertex2)) << 32) ^ std::max(vertex1, vertex2);
+    key += 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+std::uint64_t BaseTour::getHash() const {
+    return hash;
+}
+
+void BaseTour::setCheckpoint() {
+    journal.clear();
+    hasCheckpoint = true;
+}
+
+void BaseTour::rollback() {
+    // The flips of the undo are not recorded, the journal keeps its memory for the next checkpoint
+    std::vector<std::array<vertex_t, 4>> flips;
+    flips.swap(journal);
+    hasCheckpoint = false;
+    for (auto flipIterator = flips.rbegin(); flipIterator != flips.rend(); ++flipIterator) {
+        const vertex_t a = (*flipIterator)[0], b = (*flipIterator)[1], c = (*flipIterator)[2], d = (*flipIterator)[3];
+        // flip(a, b, c, d) added {b, c} and {d, a}, depending on the orientation either flip(c, b, a, d) or
+        // flip(b, c, d, a) replaces them by {a, b} and {c, d} again
+        if (successor(b) == c) {
+            flip(c, b, a, d);
+        } else {
+            flip(b, c, d, a);
+        }
+    }
+    flips.clear();
+    journal.swap(flips);
+    hasCheckpoint = true;
+}
+
+void BaseTour::discardCheckpoint() {
+    journal.clear();
+    hasCheckpoint = false;
+}
+
+std::size_t BaseTour::getJournalSize() const {
+    return journal.size();
+}
+
 std::vector<dimension_t> BaseTour::inversePermutation(const std::vector<dimension_t> &permutation) {
     std::vector<dimension_t> result(permutation.size());
     for (dimension_t i = 0; i < permutation.size(); ++i) {
@@ -122,6 +188,8 @@ std::vector<dimension_t> BaseTour::cyclicPermutation(const AlternatingWalk &alte
 }
 
 bool BaseTour::isTourAfterExchange(const AlternatingWalk &alternatingWalk) const {
+    STATISTICS_COUNT(IS_TOUR_AFTER_EXCHANGE_CALLS);
+
     // Compute the cyclic permutation and its inverse
     std::vector<dimension_t> permutation = cyclicPermutation(alternatingWalk);
     std::vector<dimension_t> indices = inversePermutation(permutation);
@@ -151,6 +219,8 @@ bool BaseTour::isTourAfterExchange(const AlternatingWalk &alternatingWalk) const
 }
 
 void BaseTour::exchange(const AlternatingWalk &alternatingWalk) {
+    TOUR_TRACE(alternatingWalk);
+
     // The "new" tour is the tour after exchanging all out-edges by in-edges, while the "old" tour is the current one
     // before this exchange.
 
@@ -272,29 +342,60 @@ dimension_t ArrayTour::distance(vertex_t vertex1, vertex_t vertex2) const {
 }
 
 void ArrayTour::setVertices(const std::vector<vertex_t> &vertexList) {
+    TOUR_TRACE(vertexList);
     sequence = vertexList;
     indices = inversePermutation(sequence);
+    resetHash(sequence);
+}
+
+void ArrayTour::setVertices(const std::vector<vertex_t> &tourSequence, dimension_t /* groupSize */) {
+    setVertices(tourSequence);
 }
 
 ArrayTour::ArrayTour(const std::vector<vertex_t> &tourSequence) {
     setVertices(tourSequence);
 }
 
+void ArrayTour::copyFrom(const BaseTour &tour) {
+    discardCheckpoint();
+    const dimension_t dimension = tour.getDimension();
+    sequence.resize(dimension);
+    indices.resize(dimension);
+    vertex_t v = 0;
+    for (dimension_t i = 0; i < dimension; ++i) {
+        sequence[i] = v;
+        indices[v] = i;
+        v = tour.successor(v);
+    }
+    hash = tour.getHash();
+}
+
+const std::vector<vertex_t> &ArrayTour::getSequence() const {
+    return sequence;
+}
+
 vertex_t ArrayTour::predecessor(vertex_t vertex) const {
+    TOUR_TRACE(TourTrace::PREDECESSOR, vertex);
     return sequence[(indices[vertex] + getDimension() - 1) % getDimension()];
 }
 
 vertex_t ArrayTour::successor(vertex_t vertex) const {
+    TOUR_TRACE(TourTrace::SUCCESSOR, vertex);
     return sequence[(indices[vertex] + 1) % getDimension()];
 }
 
 bool ArrayTour::isBetween(vertex_t before, vertex_t vertex, vertex_t after) const {
+    STATISTICS_COUNT(IS_BETWEEN_CALLS);
+    TOUR_TRACE(TourTrace::IS_BETWEEN, before, vertex, after);
     dimension_t distanceToVertex = distance(before, vertex);
     dimension_t distanceToAfter = distance(before, after);
     return distanceToVertex < distanceToAfter;
 }
 
 void ArrayTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
+    TOUR_TRACE(TourTrace::FLIP, a, b, c, d);
+    recordFlip(a, b, c, d);
+
     // Calculate the length of the two segments to decide which of them will be reversed
     dimension_t acDistance = distance(a, c);
     dimension_t dbDistance = distance(d, b);
@@ -312,6 +413,8 @@ void ArrayTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
         segmentEndIndex = indices[b];
         segmentLength = dbDistance;
     }
+    STATISTICS_COUNT(FLIPS);
+    STATISTICS_ADD(FLIP_REVERSED_LENGTH, segmentLength + 1);
     for (dimension_t i = 0; i < (segmentLength + 1) / 2; ++i) {
         vertex_t &vertex1 = sequence[(segmentStartIndex + i) % getDimension()];
         vertex_t &vertex2 = sequence[(segmentEndIndex + getDimension() - i) % getDimension()];
@@ -361,7 +464,8 @@ void TwoLevelTreeTour::SegmentParent::reverseVertices(std::list<SegmentVertex>::
 
 //             ============================== TwoLevelTreeTour class =======================================
 
-TwoLevelTreeTour::TwoLevelTreeTour(const TwoLevelTreeTour &otherTour) : dimension(otherTour.dimension),
+TwoLevelTreeTour::TwoLevelTreeTour(const TwoLevelTreeTour &otherTour) : BaseTour(otherTour),
+                                                                        dimension(otherTour.dimension),
                                                                         groupSize(otherTour.groupSize),
                                                                         parents(otherTour.parents),
                                                                         iterators(otherTour.iterators) {
@@ -378,6 +482,7 @@ TwoLevelTreeTour::TwoLevelTreeTour(const TwoLevelTreeTour &otherTour) : dimensio
 
 TwoLevelTreeTour &TwoLevelTreeTour::operator=(const TwoLevelTreeTour &otherTour) {
     if (this != &otherTour) {
+        BaseTour::operator=(otherTour);
         dimension = otherTour.dimension;
         groupSize = otherTour.groupSize;
         parents = otherTour.parents;
@@ -397,23 +502,64 @@ TwoLevelTreeTour &TwoLevelTreeTour::operator=(const TwoLevelTreeTour &otherTour)
 }
 
 
+TwoLevelTreeTour::TwoLevelTreeTour(TwoLevelTreeTour &&otherTour) noexcept: BaseTour(std::move(otherTour)),
+                                                                          dimension(otherTour.dimension),
+                                                                          groupSize(otherTour.groupSize),
+                                                                          parents(std::move(otherTour.parents)),
+                                                                          iterators(std::move(otherTour.iterators)) {
+    otherTour.dimension = 0;
+    otherTour.parents.clear();
+    otherTour.iterators.clear();
+}
+
+TwoLevelTreeTour &TwoLevelTreeTour::operator=(TwoLevelTreeTour &&otherTour) noexcept {
+    if (this != &otherTour) {
+        BaseTour::operator=(std::move(otherTour));
+        dimension = otherTour.dimension;
+        groupSize = otherTour.groupSize;
+        parents = std::move(otherTour.parents);
+        iterators = std::move(otherTour.iterators);
+        otherTour.dimension = 0;
+        otherTour.parents.clear();
+        otherTour.iterators.clear();
+    }
+
+    return *this;
+}
+
+dimension_t TwoLevelTreeTour::defaultGroupSize(dimension_t dimension) {
+    // The choices of groupSize for dimension > 300 are taken from the paper linked in Tour.h
+    if (dimension <= 300) {
+        return 2 * dimension;
+    } else if (dimension <= 100000) {
+        return 100;
+    } else {
+        return 200;
+    }
+}
+
 void TwoLevelTreeTour::setVertices(const std::vector<vertex_t> &tourSequence) {
-    dimension = tourSequence.size();
+    setVertices(tourSequence, defaultGroupSize(tourSequence.size()));
+}
 
-    // For two segments the implementation does not work and for one segment (3/4)*groupSize may not be smaller
-    // than the dimension, so for dimension <= 300 I set the groupSize to twice the dimension. This sets the number of
-    // segments to one and the TwoLevelTreeTour essentially works like an ArrayTour
+void TwoLevelTreeTour::setVertices(const std::vector<vertex_t> &tourSequence, dimension_t groupSize) {
+    TOUR_TRACE(tourSequence);
+    dimension = tourSequence.size();
+    resetHash(tourSequence);
 
-    // The choices of groupSize for all other cases is taken from the paper linked in Tour.h
+    if (groupSize == 0) {
+        groupSize = defaultGroupSize(dimension);
+    }
 
-    if (tourSequence.size() <= 300) {
+    // For two segments the implementation does not work and for one segment (3/4)*groupSize may not be smaller
+    // than the dimension, so if there would be less than three segments I set the groupSize to twice the dimension.
+    // This sets the number of segments to one and the TwoLevelTreeTour essentially works like an ArrayTour
+    if (dimension < 3 * groupSize) {
         groupSize = 2 * dimension;
-    } else if (tourSequence.size() <= 100000) {
-        groupSize = 100;
-    } else {
-        groupSize = 200;
     }
+    this->groupSize = groupSize;
 
+    parents.clear();
     iterators.resize(tourSequence.size());
     dimension_t segmentLength = groupSize; // The first segments should have groupSize elements
     std::size_t parentIndex = 0; // The index for tourSequence
@@ -448,6 +594,10 @@ TwoLevelTreeTour::TwoLevelTreeTour(const std::vector<vertex_t> &tourSequence) {
     setVertices(tourSequence);
 }
 
+dimension_t TwoLevelTreeTour::getGroupSize() const {
+    return groupSize;
+}
+
 
 dimension_t TwoLevelTreeTour::getDimension() const {
     return dimension;
@@ -464,6 +614,7 @@ const TwoLevelTreeTour::SegmentParent &TwoLevelTreeTour::getNextParent(
 }
 
 vertex_t TwoLevelTreeTour::predecessor(vertex_t vertex) const {
+    TOUR_TRACE(TourTrace::PREDECESSOR, vertex);
     auto iterator = iterators[vertex];
     const SegmentParent &parent = *(iterator->parentIterator);
     if ((!parent.reversed and iterator == parent.vertices.begin()) or
@@ -475,6 +626,7 @@ vertex_t TwoLevelTreeTour::predecessor(vertex_t vertex) const {
 }
 
 vertex_t TwoLevelTreeTour::successor(vertex_t vertex) const {
+    TOUR_TRACE(TourTrace::SUCCESSOR, vertex);
     auto iterator = iterators[vertex];
     const SegmentParent &parent = *(iterator->parentIterator);
     if ((!parent.reversed and std::next(iterator) == parent.vertices.end()) or
@@ -486,6 +638,9 @@ vertex_t TwoLevelTreeTour::successor(vertex_t vertex) const {
 }
 
 bool TwoLevelTreeTour::isBetween(vertex_t before, vertex_t vertex, vertex_t after) const {
+    STATISTICS_COUNT(IS_BETWEEN_CALLS);
+    TOUR_TRACE(TourTrace::IS_BETWEEN, before, vertex, after);
+
     auto beforeIterator = iterators[before];
     auto vertexIterator = iterators[vertex];
     auto afterIterator = iterators[after];
@@ -609,7 +764,10 @@ void TwoLevelTreeTour::reverseParents(std::list<SegmentParent>::iterator first,
 }
 
 
-void TwoLevelTreeTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
+void TwoLevelTreeTour::flipPath(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
+    // flipPath calls itself recursively, so only the cases 1 and 2 (which actually reverse a path) count as a flip. The
+    // reversed length is the number of SegmentParents (case 1) or SegmentVertices (case 2) that change their order.
+
     // Get the segment vertices and parents corresponding to a, b, c and d
     SegmentVertex &aVertex = *iterators[a];
     SegmentVertex &bVertex = *iterators[b];
@@ -625,9 +783,12 @@ void TwoLevelTreeTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
     // Reverse a range of consecutive parents that correspond to a-c or d-b
     if (aParent.firstVertex() == a and cParent.lastVertex() == c) {
         // Reverse one of these paths
+        STATISTICS_COUNT(FLIPS);
         if (cParent.sequenceNumber >= aParent.sequenceNumber) {
+            STATISTICS_ADD(FLIP_REVERSED_LENGTH, cParent.sequenceNumber - aParent.sequenceNumber + 1);
             reverseParents(aVertex.parentIterator, cVertex.parentIterator);
         } else {
+            STATISTICS_ADD(FLIP_REVERSED_LENGTH, bParent.sequenceNumber - dParent.sequenceNumber + 1);
             reverseParents(dVertex.parentIterator, bVertex.parentIterator);
         }
 
@@ -670,9 +831,11 @@ void TwoLevelTreeTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
             if (end != parent.lastVertex()) {
                 mergeHalfSegment(successor(end), true);
             }
-            flip(a, b, c, d); // This is now handled using case 1
+            flipPath(a, b, c, d); // This is now handled using case 1
         } else {
             // Flip the path inside of parent.vertices
+            STATISTICS_COUNT(FLIPS);
+            STATISTICS_ADD(FLIP_REVERSED_LENGTH, length + 1);
             if (parent.reversed) {
                 // iterators[start] needs to come before iterators[end] inside the segment
                 std::swap(start, end);
@@ -719,5 +882,11 @@ void TwoLevelTreeTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
     // If cParent (= dParent) was the neighboring segment of aParent (= bParent) it can happen that a half of aParent
     // gets merged to cParent and then the half that contains the newly merged vertices gets merged back to aParent. In
     // this case, the flip can now be handled by case 2.
-    flip(a, b, c, d);
+    flipPath(a, b, c, d);
+}
+
+void TwoLevelTreeTour::flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) {
+    TOUR_TRACE(TourTrace::FLIP, a, b, c, d);
+    recordFlip(a, b, c, d);
+    flipPath(a, b, c, d);
 }
@@ -5,7 +5,9 @@
 #ifndef LINKERNIGHANALGORITHM_TOUR_H
 #define LINKERNIGHANALGORITHM_TOUR_H
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <vector>
@@ -92,8 +94,51 @@ public: // pure virtual functions that need to be implemented by subclasses
     // Expects successor(b) = a and successor(c) = d
     virtual void flip(vertex_t a, vertex_t b, vertex_t c, vertex_t d) = 0;
 
+protected:
+    // The hash of the tour (see getHash), subclasses set it in setVertices with resetHash and update it in flip with
+    // recordFlip
+    std::uint64_t hash = 0;
+
+    // The arguments of all flips since the last checkpoint in the order they were made (see setCheckpoint)
+    std::vector<std::array<vertex_t, 4>> journal;
+
+    // Whether a checkpoint is set, i.e. whether recordFlip appends to journal
+    bool hasCheckpoint = false;
+
+    // Sets hash to the hash of the tour given by tourSequence and discards the checkpoint, because the flips before
+    // setVertices can not be undone
+    void resetHash(const std::vector<vertex_t> &tourSequence);
+
+    // Updates hash for flip(a, b, c, d), i.e. removes the keys of {a, b} and {c, d} and adds the keys of {b, c} and
+    // {d, a}, and appends the flip to journal if a checkpoint is set
+    void recordFlip(vertex_t a, vertex_t b, vertex_t c, vertex_t d);
+
 public: // functions that all Tour classes have in common and that only depend on the functions above
 
+    // Returns a pseudo-random key for the edge {vertex1, vertex2}, the same for both orders of the vertices
+    static std::uint64_t edgeKey(vertex_t vertex1, vertex_t vertex2);
+
+    // Returns the Zobrist hash of the tour, the XOR of the edgeKey of all its edges. Tours with the same edges have the
+    // same hash and different tours have different hashes with high probability. It is updated in constant time by
+    // flip
+    std::uint64_t getHash() const;
+
+    // Sets a checkpoint of the current tour: from now on every flip is recorded, so that rollback can undo them in
+    // time proportional to the number of flips instead of copying the whole tour. A previous checkpoint is replaced and
+    // setVertices discards the checkpoint
+    void setCheckpoint();
+
+    // Undoes all flips since the checkpoint, afterwards the tour has the same edges as at the checkpoint (possibly in
+    // the opposite orientation) and the checkpoint is still set
+    // Expects that a checkpoint is set
+    void rollback();
+
+    // Discards the checkpoint and stops recording flips
+    void discardCheckpoint();
+
+    // Returns the number of flips since the checkpoint (0 if none is set)
+    std::size_t getJournalSize() const;
+
     // Compute the inverse permutation to a permutation of the numbers 0 to n-1, i.e. a vector inv such that
     // permutation[inv[i]] == i for all 0 <= i < n
     // Expects that permutation contains every number 0 to permutation.size()-1 exactly once
@@ -148,10 +193,22 @@ public:
     // Expects a vector containing each vertex 0 to tourSequence.size()-1 exactly once and overrides all data
     void setVertices(const std::vector<vertex_t> &tourSequence) override;
 
+    // The same as setVertices(tourSequence), there are no segments so groupSize is ignored
+    // This allows to set the groupSize without knowing whether Tour is ArrayTour or TwoLevelTreeTour
+    void setVertices(const std::vector<vertex_t> &tourSequence, dimension_t groupSize);
+
     // Initialize the tour with a sequence of vertices
     // Expects a vector containing each vertex 0 to tourSequence.size()-1 exactly once
     explicit ArrayTour(const std::vector<vertex_t> &tourSequence);
 
+    // Stores the current order of tour in this tour, the memory of this tour is reused. This makes an ArrayTour a
+    // cheap snapshot of a TwoLevelTreeTour (see TourSnapshot): the copy only writes two arrays instead of allocating
+    // a list node for every vertex
+    void copyFrom(const BaseTour &tour);
+
+    // Returns the vertices in the order of the tour, starting at an arbitrary vertex
+    const std::vector<vertex_t> &getSequence() const;
+
     // Returns the number of vertices in the tour
     dimension_t getDimension() const override;
 
@@ -267,6 +324,10 @@ private:
     // left = predecessor-direction)
     void mergeHalfSegment(vertex_t v, bool mergeToTheRight);
 
+    // The implementation of flip, it may split and merge segments and call itself again, so flip updates the hash of
+    // the tour only once before calling it
+    void flipPath(vertex_t a, vertex_t b, vertex_t c, vertex_t d);
+
 public:
     TwoLevelTreeTour() = default;
 
@@ -276,14 +337,31 @@ public:
     // The copy assignment operator: Copy the state of otherTour into this tour
     TwoLevelTreeTour &operator=(const TwoLevelTreeTour &otherTour);
 
-    // Initialize the tour with a sequence of vertices
+    // The move constructor: The lists are moved, so all iterators stay valid and otherTour is left empty
+    TwoLevelTreeTour(TwoLevelTreeTour &&otherTour) noexcept;
+
+    // The move assignment operator: The same as the move constructor
+    TwoLevelTreeTour &operator=(TwoLevelTreeTour &&otherTour) noexcept;
+
+    // Returns the groupSize used by setVertices for a tour with dimension vertices
+    static dimension_t defaultGroupSize(dimension_t dimension);
+
+    // Initialize the tour with a sequence of vertices and the default groupSize
     // Expects a vector containing each vertex 0 to tourSequence.size()-1 exactly once and overrides all data
     void setVertices(const std::vector<vertex_t> &tourSequence) override;
 
+    // Initialize the tour with a sequence of vertices and segments of roughly groupSize vertices, 0 means the default
+    // groupSize
+    // Expects a vector containing each vertex 0 to tourSequence.size()-1 exactly once and overrides all data
+    void setVertices(const std::vector<vertex_t> &tourSequence, dimension_t groupSize);
+
     // Initialize the tour with a sequence of vertices
     // Expects a vector containing each vertex 0 to tourSequence.size()-1 exactly once
     explicit TwoLevelTreeTour(const std::vector<vertex_t> &tourSequence);
 
+    // Returns the groupSize of the tour
+    dimension_t getGroupSize() const;
+
     // Returns the number of vertices in the tour
     dimension_t getDimension() const override;
 
@@ -304,4 +382,7 @@ public:
 
 using Tour = TwoLevelTreeTour;
 
+// A compact copy of a tour that is only read, e.g. the best tour found so far (see ArrayTour::copyFrom)
+using TourSnapshot = ArrayTour;
+
 #endif //LINKERNIGHANALGORITHM_TOUR_H
@@ -0,0 +1,385 @@
+// This program compares the tour implementations ArrayTour and TwoLevelTreeTour (with different groupSizes) by
+// replaying traces of tour operations on them. There are two kinds of traces:
+// (1) Recorded traces: A trial of the Lin-Kernighan-heuristic is run on a random uniform problem and every operation
+//     on a tour is recorded with TourTrace.h. These traces are exactly the operations of improveTour, but they can only
+//     be recorded for dimensions where a trial finishes in reasonable time.
+// (2) Synthetic traces: For every dimension up to 10^6 random uniform points are generated and a tour along strips is
+//     used as start tour. Then random flips, candidate-local flips (the new edge connects nearest neighbors),
+//     successor/predecessor/isBetween queries for nearest neighbors and exchanges of random sequential 3-opt and 5-opt
+//     walks along nearest neighbors are generated and recorded.
+// The replay of a flip does not depend on the orientation of the tour (see replayTrace), so each trace can be replayed
+// on every implementation. After the replay the tours of all implementations are compared. The default TwoLevelTreeTour
+// is replayed a second time with a checkpoint after the start tour, then its journal of flips is rolled back, which has
+// to restore the start tour.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LinKernighanHeuristic.h"
+#include "Tour.h"
+#include "TourTrace.h"
+#include "TsplibUtils.h"
+
+const std::string helpString = R""(
+Usage:
+    LinKernighanTourBenchmark [options]
+
+Options:
+    --recorded-dimensions=integer,integer,...
+        The dimensions of the problems on which a trial of the heuristic is recorded (default: 1000,2000)
+    --synthetic-dimensions=integer,integer,...
+        The dimensions for the synthetic traces (default: 1000,10000,100000,1000000)
+    --group-sizes=integer,integer,...
+        The groupSizes of the TwoLevelTreeTour that are compared to the default (default: 25,50,100,200,400,800)
+    --operations=integer
+        The number of queries in a synthetic trace, the traces with flips and exchanges are shorter. (default: 1000000)
+    --max-recorded-operations=integer
+        Stop the recording of a trial after this many operations (default: 4000000)
+    --seed=integer
+        The seed for the random problems and traces (default: 1)
+)"";
+
+using Points = std::vector<std::vector<double>>;
+
+// Parse a comma separated list of integers
+bool parseList(std::stringstream &stringStream, std::vector<std::size_t> &values) {
+    values.clear();
+    std::size_t value;
+    while (stringStream >> value) {
+        values.push_back(value);
+        stringStream.ignore(1, ',');
+    }
+    stringStream.clear();
+    return !values.empty();
+}
+
+// Generate dimension random points in the square [0, 10^6]^2
+Points randomPoints(dimension_t dimension, std::mt19937 &randomNumberGenerator) {
+    std::uniform_real_distribution<double> distribution(0, 1e6);
+    Points points(dimension);
+    for (std::vector<double> &point : points) {
+        point = {std::round(distribution(randomNumberGenerator)), std::round(distribution(randomNumberGenerator))};
+    }
+    return points;
+}
+
+// Returns a tour that visits the points in vertical strips, alternating upwards and downwards
+std::vector<vertex_t> stripTour(const Points &points) {
+    const double numberOfStrips = std::max(1.0, std::floor(std::sqrt(points.size() / 2.0)));
+    const double stripWidth = 1e6 / numberOfStrips + 1e-9;
+    std::vector<vertex_t> tourSequence(points.size());
+    std::iota(tourSequence.begin(), tourSequence.end(), 0);
+    auto key = [&points, stripWidth](vertex_t v) {
+        long strip = static_cast<long>(points[v][0] / stripWidth);
+        return std::make_pair(strip, (strip % 2 == 0) ? points[v][1] : -points[v][1]);
+    };
+    std::sort(tourSequence.begin(), tourSequence.end(), [&key](vertex_t v, vertex_t w) { return key(v) < key(w); });
+    return tourSequence;
+}
+
+// Record the operations of a single trial of the heuristic on a random problem
+TourTrace::Trace recordTrial(dimension_t dimension, std::size_t maxOperations, std::mt19937 &randomNumberGenerator) {
+    Points points = randomPoints(dimension, randomNumberGenerator);
+    TsplibProblem problem = TsplibProblem::fromCoordinates("random" + std::to_string(dimension),
+                                                           TsplibProblem::EUC_2D, points);
+    std::vector<std::vector<vertex_t>> neighbors = problem.gridNearestNeighbors(5);
+    CandidateEdges candidateEdges(problem, neighbors);
+
+    LinKernighanHeuristic heuristic(problem, candidateEdges, randomNumberGenerator());
+    TourTrace::startRecording(maxOperations);
+    heuristic.findBestTour(1, 0, 0, false);
+    return TourTrace::stopRecording();
+}
+
+// Generate the synthetic traces for dimension random points (see the top of this file)
+std::vector<std::pair<std::string, TourTrace::Trace>>
+syntheticTraces(dimension_t dimension, std::size_t numberOfOperations, std::mt19937 &randomNumberGenerator) {
+    Points points = randomPoints(dimension, randomNumberGenerator);
+    // Only the nearest neighbors are needed, so the distances are not stored
+    const TsplibProblem problem = TsplibProblem::fromCoordinates("random" + std::to_string(dimension),
+                                                                 TsplibProblem::EUC_2D, points, false);
+    std::vector<std::vector<vertex_t>> neighbors = problem.gridNearestNeighbors(5);
+    const std::vector<vertex_t> startSequence = stripTour(points);
+    std::uniform_int_distribution<vertex_t> randomVertex(0, dimension - 1);
+    std::uniform_int_distribution<std::size_t> randomNeighbor(0, neighbors[0].size() - 1);
+    std::bernoulli_distribution randomBool(0.5);
+
+    // The traces are recorded on a TwoLevelTreeTour, because it is the fastest for large dimensions
+    std::vector<std::pair<std::string, TourTrace::Trace>> traces;
+    TwoLevelTreeTour tour;
+    auto record = [&](const std::string &name, std::size_t count, const std::function<void()> &operation) {
+        TourTrace::startRecording(std::numeric_limits<std::size_t>::max());
+        tour.setVertices(startSequence);
+        for (std::size_t i = 0; i < count; ++i) {
+            operation();
+        }
+        traces.emplace_back(name, TourTrace::stopRecording());
+    };
+
+    // flip(a, predecessor(a), c, successor(c)) replaces {predecessor(a), a} and {c, successor(c)}
+    auto flipAt = [&tour](vertex_t a, vertex_t c) {
+        vertex_t b = tour.predecessor(a);
+        vertex_t d = tour.successor(c);
+        if (a != c and b != c and a != d) {
+            tour.flip(a, b, c, d);
+        }
+    };
+
+    record("queries", numberOfOperations, [&]() {
+        vertex_t v = randomVertex(randomNumberGenerator);
+        const std::vector<vertex_t> &vNeighbors = neighbors[v];
+        tour.successor(v);
+        tour.predecessor(vNeighbors[randomNeighbor(randomNumberGenerator)]);
+        tour.isBetween(v, vNeighbors[randomNeighbor(randomNumberGenerator)],
+                       vNeighbors[randomNeighbor(randomNumberGenerator)]);
+    });
+    record("random-flips", std::max<std::size_t>(1, numberOfOperations / 1000), [&]() {
+        flipAt(randomVertex(randomNumberGenerator), randomVertex(randomNumberGenerator));
+    });
+    record("local-flips", numberOfOperations / 50, [&]() {
+        vertex_t a = randomVertex(randomNumberGenerator);
+        flipAt(a, neighbors[a][randomNeighbor(randomNumberGenerator)]);
+    });
+
+    // A sequential k-opt move starts with a tour edge {t1, t2}, adds an edge {t2, t3} to a nearest neighbor t3 of t2,
+    // removes a tour edge {t3, t4} and so on until it is closed with {t2k, t1}
+    auto exchangeWalk = [&](std::size_t k) {
+        for (std::size_t attempt = 0; attempt < 100; ++attempt) {
+            AlternatingWalk walk;
+            vertex_t current = randomVertex(randomNumberGenerator);
+            walk.push_back(current);
+            current = randomBool(randomNumberGenerator) ? tour.successor(current) : tour.predecessor(current);
+            walk.push_back(current);
+            bool valid = true;
+            for (std::size_t i = 1; i < k and valid; ++i) {
+                vertex_t next = neighbors[current][randomNeighbor(randomNumberGenerator)];
+                vertex_t nextOnTour = randomBool(randomNumberGenerator) ? tour.successor(next) : tour.predecessor(next);
+                valid = std::find(walk.begin(), walk.end(), next) == walk.end() and
+                        std::find(walk.begin(), walk.end(), nextOnTour) == walk.end() and next != nextOnTour;
+                walk.push_back(next);
+                walk.push_back(nextOnTour);
+                current = nextOnTour;
+            }
+            if (valid) {
+                AlternatingWalk closedWalk = walk.close();
+                if (tour.isTourAfterExchange(closedWalk)) {
+                    tour.exchange(closedWalk);
+                    return;
+                }
+            }
+        }
+    };
+    record("3-opt-exchanges", numberOfOperations / 100, [&]() { exchangeWalk(3); });
+    record("5-opt-exchanges", numberOfOperations / 100, [&]() { exchangeWalk(5); });
+
+    return traces;
+}
+
+// Replays trace on tour and returns the running time in seconds
+// Flips are replayed independently of the orientation of the tour: If successor(b) = a does not hold, the orientation
+// of tour is opposite to the one during the recording and flip(b, a, d, c) removes and adds the same edges
+template<class TourType>
+double replayTrace(const TourTrace::Trace &trace, TourType &tour,
+                   const std::function<void(TourType &, const std::vector<vertex_t> &)> &setVertices) {
+    vertex_t sink = 0; // Use the results of all queries, so that they are not optimized away
+    const auto startTime = std::chrono::steady_clock::now();
+    for (const TourTrace::Entry &entry : trace.entries) {
+        const vertex_t *arguments = entry.arguments;
+        switch (entry.operation) {
+            case TourTrace::SET_VERTICES:
+                setVertices(tour, trace.tourSequences[arguments[0]]);
+                break;
+            case TourTrace::SUCCESSOR:
+                sink += tour.successor(arguments[0]);
+                break;
+            case TourTrace::PREDECESSOR:
+                sink += tour.predecessor(arguments[0]);
+                break;
+            case TourTrace::IS_BETWEEN:
+                sink += tour.isBetween(arguments[0], arguments[1], arguments[2]);
+                break;
+            case TourTrace::FLIP:
+                if (tour.successor(arguments[1]) == arguments[0]) {
+                    tour.flip(arguments[0], arguments[1], arguments[2], arguments[3]);
+                } else {
+                    tour.flip(arguments[1], arguments[0], arguments[3], arguments[2]);
+                }
+                break;
+            case TourTrace::EXCHANGE:
+                tour.exchange(trace.alternatingWalks[arguments[0]]);
+                break;
+        }
+    }
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - startTime;
+    if (sink == std::numeric_limits<vertex_t>::max()) {
+        std::cout << ""; // Practically never happens, but the compiler cannot know that
+    }
+    return time.count();
+}
+
+// Checks whether two tours contain the same edges
+bool sameEdges(const BaseTour &tour, const BaseTour &otherTour) {
+    for (vertex_t v = 0; v < tour.getDimension(); ++v) {
+        if (!otherTour.containsEdge(v, tour.successor(v))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replays trace on all tour implementations and prints the results
+// Returns false if the replays did not lead to the same tour
+bool compareImplementations(const std::string &name, dimension_t dimension, const TourTrace::Trace &trace,
+                            const std::vector<std::size_t> &groupSizes, bool includeArrayTour) {
+    const double numberOfOperations = std::max<double>(1, trace.entries.size());
+    auto printResult = [&](const std::string &implementation, double seconds) {
+        std::cout << std::left << std::setw(18) << name << std::setw(10) << dimension << std::setw(12)
+                  << trace.entries.size() << std::setw(32) << implementation << std::fixed << std::setprecision(1)
+                  << seconds * 1e9 / numberOfOperations << std::defaultfloat << std::endl;
+    };
+
+    std::vector<std::pair<std::string, double>> results;
+    ArrayTour arrayTour;
+    if (includeArrayTour) {
+        double seconds = replayTrace<ArrayTour>(trace, arrayTour, [](ArrayTour &tour,
+                                                                     const std::vector<vertex_t> &sequence) {
+            tour.setVertices(sequence);
+        });
+        printResult("ArrayTour", seconds);
+        results.emplace_back("ArrayTour", seconds);
+    }
+
+    TwoLevelTreeTour defaultTour;
+    double seconds = replayTrace<TwoLevelTreeTour>(trace, defaultTour, [](TwoLevelTreeTour &tour,
+                                                                          const std::vector<vertex_t> &sequence) {
+        tour.setVertices(sequence);
+    });
+    std::string implementation = "TwoLevelTreeTour(default=" + std::to_string(defaultTour.getGroupSize()) + ")";
+    printResult(implementation, seconds);
+    results.emplace_back(implementation, seconds);
+    bool consistent = !includeArrayTour or sameEdges(arrayTour, defaultTour);
+
+    // The same replay with a checkpoint after the start tour, every flip is recorded in the journal. Then the rollback
+    // is timed, it has to restore the start tour. It is the same implementation, so it does not compete for the fastest
+    TwoLevelTreeTour journaledTour;
+    seconds = replayTrace<TwoLevelTreeTour>(trace, journaledTour, [](TwoLevelTreeTour &tour,
+                                                                     const std::vector<vertex_t> &sequence) {
+        tour.setVertices(sequence);
+        tour.setCheckpoint();
+    });
+    printResult("TwoLevelTreeTour(journal)", seconds);
+    consistent = consistent and sameEdges(defaultTour, journaledTour);
+    if (!trace.tourSequences.empty()) {
+        const std::size_t journalSize = journaledTour.getJournalSize();
+        const auto startTime = std::chrono::steady_clock::now();
+        journaledTour.rollback();
+        const std::chrono::duration<double> rollbackTime = std::chrono::steady_clock::now() - startTime;
+        std::cout << "    rollback of " << journalSize << " flips: " << std::fixed << std::setprecision(1)
+                  << rollbackTime.count() * 1e9 / std::max<double>(1, journalSize) << std::defaultfloat
+                  << " ns per flip" << std::endl;
+        TwoLevelTreeTour startTour;
+        startTour.setVertices(trace.tourSequences.back());
+        consistent = consistent and sameEdges(startTour, journaledTour);
+    }
+
+    for (std::size_t groupSize : groupSizes) {
+        TwoLevelTreeTour tour;
+        seconds = replayTrace<TwoLevelTreeTour>(trace, tour, [groupSize](TwoLevelTreeTour &tour,
+                                                                         const std::vector<vertex_t> &sequence) {
+            tour.setVertices(sequence, groupSize);
+        });
+        if (tour.getGroupSize() != groupSize) {
+            continue; // The groupSize is too big for this dimension and the result is the same as for 2 * dimension
+        }
+        implementation = "TwoLevelTreeTour(" + std::to_string(groupSize) + ")";
+        printResult(implementation, seconds);
+        results.emplace_back(implementation, seconds);
+        consistent = consistent and sameEdges(defaultTour, tour);
+    }
+
+    auto best = std::min_element(results.begin(), results.end(),
+                                 [](const std::pair<std::string, double> &result,
+                                    const std::pair<std::string, double> &otherResult) {
+                                     return result.second < otherResult.second;
+                                 });
+    std::cout << "    fastest: " << best->first << std::endl;
+    if (!consistent) {
+        std::cerr << "    The replays on the different implementations led to different tours" << std::endl;
+    }
+    return consistent;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::size_t> recordedDimensions{1000, 2000};
+    std::vector<std::size_t> syntheticDimensions{1000, 10000, 100000, 1000000};
+    std::vector<std::size_t> groupSizes{25, 50, 100, 200, 400, 800};
+    std::size_t numberOfOperations = 1000000;
+    std::size_t maxRecordedOperations = 4000000;
+    std::mt19937::result_type seed = 1;
+
+    std::stringstream stringStream;
+    std::string option;
+    for (int i = 1; i < argc; ++i) {
+        stringStream << argv[i];
+        std::getline(stringStream, option, '=');
+        bool valid = true;
+        if (option == "--help") {
+            std::cout << helpString;
+            return 0;
+        } else if (option == "--recorded-dimensions") {
+            valid = parseList(stringStream, recordedDimensions);
+        } else if (option == "--synthetic-dimensions") {
+            valid = parseList(stringStream, syntheticDimensions);
+        } else if (option == "--group-sizes") {
+            valid = parseList(stringStream, groupSizes);
+        } else if (option == "--operations") {
+            stringStream >> numberOfOperations;
+        } else if (option == "--max-recorded-operations") {
+            stringStream >> maxRecordedOperations;
+        } else if (option == "--seed") {
+            stringStream >> seed;
+        } else {
+            std::cerr << "An unknown option was given" << std::endl;
+            std::cout << helpString;
+            return 1;
+        }
+        if (stringStream.fail() or !valid) {
+            std::cerr << "One of the options has an invalid format" << std::endl;
+            std::cout << helpString;
+            return 1;
+        }
+        stringStream.clear();
+    }
+
+    std::mt19937 randomNumberGenerator(seed);
+    bool consistent = true;
+    std::cout << std::left << std::setw(18) << "trace" << std::setw(10) << "dimension" << std::setw(12)
+              << "operations" << std::setw(32) << "implementation" << "ns/operation" << std::endl;
+
+    for (std::size_t dimension : recordedDimensions) {
+        TourTrace::Trace trace = recordTrial(dimension, maxRecordedOperations, randomNumberGenerator);
+        consistent = compareImplementations("improveTour", dimension, trace, groupSizes, true) and consistent;
+    }
+
+    for (std::size_t dimension : syntheticDimensions) {
+        for (const auto &namedTrace : syntheticTraces(dimension, numberOfOperations, randomNumberGenerator)) {
+            // The ArrayTour takes hours for random flips in large tours
+            bool includeArrayTour = dimension <= 100000 or namedTrace.first != "random-flips";
+            consistent = compareImplementations(namedTrace.first, dimension, namedTrace.second, groupSizes,
+                                                includeArrayTour) and consistent;
+        }
+    }
+
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "Statistics.h"
+#include "Tour.h"
+#include "TourMerging.h"
+#include "TsplibUtils.h"
+
+// ============================================ Partition crossover ====================================================
+
+Tour mergeTours(const TsplibProblem &tsplibProblem, const BaseTour &tour1, const BaseTour &tour2,
+                dimension_t groupSize) {
+    STATISTICS_TIMER(TOUR_MERGING);
+
+    const dimension_t dimension = tsplibProblem.getDimension();
+    const BaseTour *const tours[] = {&tour1, &tour2};
+    const std::size_t NO_COMPONENT = std::numeric_limits<std::size_t>::max();
+
+    // Returns whether the edge {v, w} of one of the tours is contained in tours[t]
+    auto isInTour = [&tours](std::size_t t, vertex_t v, vertex_t w) {
+        return tours[t]->successor(v) == w or tours[t]->predecessor(v) == w;
+    };
+    // Returns whether the edge {v, w} of one of the tours is contained in both tours
+    auto isShared = [&isInTour](vertex_t v, vertex_t w) {
+        return isInTour(0, v, w) and isInTour(1, v, w);
+    };
+
+    // Find the connected components of the edges that are contained in only one of the tours by a depth-first search.
+    // Vertices whose tour edges are all shared do not belong to a component
+    std::vector<std::size_t> component(dimension, NO_COMPONENT);
+    std::size_t numberOfComponents = 0;
+    std::vector<vertex_t> stack;
+    for (vertex_t start = 0; start < dimension; ++start) {
+        if (component[start] != NO_COMPONENT or (isShared(start, tour1.predecessor(start)) and
+                                                 isShared(start, tour1.successor(start)))) {
+            continue;
+        }
+        component[start] = numberOfComponents;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const vertex_t v = stack.back();
+            stack.pop_back();
+            for (const BaseTour *tour : tours) {
+                for (vertex_t w : {tour->predecessor(v), tour->successor(v)}) {
+                    if (component[w] == NO_COMPONENT and !isShared(v, w)) {
+                        component[w] = numberOfComponents;
+                        stack.push_back(w);
+                    }
+                }
+            }
+        }
+        ++numberOfComponents;
+    }
+
+    // componentLength[t][c] is the length of the edges of tours[t] in component c that are not shared. A portal is a
+    // vertex of a component with a shared edge to a vertex outside of the component, outside[p] is that vertex for the
+    // portal p. No vertex can have two such edges, otherwise it would not belong to a component
+    std::vector<signed_distance_t> componentLength[2] = {std::vector<signed_distance_t>(numberOfComponents, 0),
+                                                         std::vector<signed_distance_t>(numberOfComponents, 0)};
+    signed_distance_t tourLength[2] = {0, 0};
+    std::vector<vertex_t> portals;
+    std::vector<vertex_t> outside(dimension, dimension);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        for (std::size_t t = 0; t < 2; ++t) {
+            const vertex_t w = tours[t]->successor(v);
+            const auto length = static_cast<signed_distance_t>(tsplibProblem.dist(v, w));
+            tourLength[t] += length;
+            if (component[v] != NO_COMPONENT and !isShared(v, w)) {
+                componentLength[t][component[v]] += length;
+            }
+        }
+        if (component[v] != NO_COMPONENT) {
+            for (vertex_t w : {tour1.predecessor(v), tour1.successor(v)}) {
+                if (component[w] != component[v] and isShared(v, w)) {
+                    portals.push_back(v);
+                    outside[v] = w;
+                }
+            }
+        }
+    }
+
+    // Inside of a component, each tour consists of paths between its portals. partner[t][p] is the other end of the
+    // path of tours[t] that starts at the portal p. If both tours connect the same pairs of portals, the paths of one
+    // tour can be replaced by the paths of the other tour and the result is still a tour. For components with two
+    // portals this is always the case
+    std::vector<vertex_t> partner[2] = {std::vector<vertex_t>(dimension, dimension),
+                                        std::vector<vertex_t>(dimension, dimension)};
+    for (std::size_t t = 0; t < 2; ++t) {
+        for (vertex_t portal : portals) {
+            if (partner[t][portal] != dimension) {
+                continue;
+            }
+            vertex_t previous = outside[portal];
+            vertex_t current = portal;
+            while (true) {
+                const vertex_t next = tours[t]->successor(current) != previous ? tours[t]->successor(current)
+                                                                               : tours[t]->predecessor(current);
+                if (component[next] != component[portal]) {
+                    break;
+                }
+                previous = current;
+                current = next;
+            }
+            partner[t][portal] = current;
+            partner[t][current] = portal;
+        }
+    }
+    std::vector<bool> isExchangeable(numberOfComponents, true);
+    for (vertex_t portal : portals) {
+        if (partner[0][portal] != partner[1][portal]) {
+            isExchangeable[component[portal]] = false;
+        }
+    }
+
+    // Take every component from base, except the exchangeable components that are shorter in the other tour
+    std::size_t bestBase = 0;
+    signed_distance_t bestLength = std::numeric_limits<signed_distance_t>::max();
+    for (std::size_t base = 0; base < 2; ++base) {
+        signed_distance_t length = tourLength[base];
+        for (std::size_t c = 0; c < numberOfComponents; ++c) {
+            if (isExchangeable[c] and componentLength[1 - base][c] < componentLength[base][c]) {
+                length -= componentLength[base][c] - componentLength[1 - base][c];
+            }
+        }
+        if (length < bestLength) {
+            bestBase = base;
+            bestLength = length;
+        }
+    }
+
+    // Follow the chosen edges of every vertex to get the merged tour. If no component improves the shorter tour, all
+    // components are taken from it and the merged tour is a copy of it
+    const bool isImproved = bestLength < tourLength[bestBase];
+    std::vector<std::size_t> chosenTour(numberOfComponents, bestBase);
+    for (std::size_t c = 0; c < numberOfComponents; ++c) {
+        if (isImproved and isExchangeable[c] and componentLength[1 - bestBase][c] < componentLength[bestBase][c]) {
+            chosenTour[c] = 1 - bestBase;
+        }
+    }
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(dimension);
+    std::vector<bool> isVisited(dimension, false);
+    vertex_t previous = dimension; // No vertex
+    vertex_t current = 0;
+    do {
+        tourSequence.push_back(current);
+        isVisited[current] = true;
+        const BaseTour *tour = tours[component[current] == NO_COMPONENT ? bestBase : chosenTour[component[current]]];
+        const vertex_t next = tour->successor(current) != previous ? tour->successor(current)
+                                                                     : tour->predecessor(current);
+        previous = current;
+        current = next;
+    } while (current != 0 and !isVisited[current]);
+
+    // The chosen edges always form a single tour, but if they close a cycle early or visit a vertex twice, the shorter
+    // tour is returned instead of an invalid tour
+    if (tourSequence.size() != dimension or current != 0) {
+        const BaseTour *shorterTour = tours[tourLength[1] < tourLength[0] ? 1 : 0];
+        tourSequence.clear();
+        vertex_t v = 0;
+        do {
+            tourSequence.push_back(v);
+            v = shorterTour->successor(v);
+        } while (v != 0);
+    }
+
+    Tour mergedTour;
+    mergedTour.setVertices(tourSequence, groupSize);
+    return mergedTour;
+}
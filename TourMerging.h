@@ -0,0 +1,22 @@
+#ifndef LINKERNIGHANALGORITHM_TOURMERGING_H
+#define LINKERNIGHANALGORITHM_TOURMERGING_H
+
+#include "Tour.h"
+#include "TsplibUtils.h"
+
+// ============================================ Partition crossover ====================================================
+
+// Merges two tours by a partition crossover (GPX), the result is never longer than the shorter one of both tours.
+//
+// Only the union graph of the edges of both tours is searched: after removing the edges contained in both tours, the
+// remaining edges fall apart into connected components. If a component is connected to the rest of the tour by only two
+// shared edges, both tours visit its vertices on a single path between the same two vertices, so the shorter one of the
+// two paths can be chosen independently for every such component. All other components are taken from one of the two
+// tours, the function tries both and returns the shorter result.
+// The effort is linear in the dimension and independent of the number of candidate edges. The tours may be of any
+// implementation of BaseTour, e.g. a TourSnapshot. groupSize is the groupSize of the merged tour (see
+// TwoLevelTreeTour), 0 means the default.
+Tour mergeTours(const TsplibProblem &tsplibProblem, const BaseTour &tour1, const BaseTour &tour2,
+                dimension_t groupSize = 0);
+
+#endif //LINKERNIGHANALGORITHM_TOURMERGING_H
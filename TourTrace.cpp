@@ -0,0 +1,58 @@
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "TourTrace.h"
+
+namespace {
+    // The recording state of the current thread
+    thread_local bool recording = false;
+    thread_local std::size_t maximumEntries = 0;
+    thread_local std::size_t suspensionDepth = 0;
+    thread_local TourTrace::Trace trace;
+
+    // Returns whether an operation should be recorded right now
+    bool shouldRecord() {
+        return recording and suspensionDepth == 0 and trace.entries.size() < maximumEntries;
+    }
+}
+
+void TourTrace::startRecording(std::size_t maxEntries) {
+    trace = Trace();
+    recording = true;
+    maximumEntries = maxEntries;
+    suspensionDepth = 0;
+}
+
+TourTrace::Trace TourTrace::stopRecording() {
+    recording = false;
+    Trace result = std::move(trace);
+    trace = Trace();
+    return result;
+}
+
+TourTrace::Scope::Scope(Operation operation, vertex_t a, vertex_t b, vertex_t c, vertex_t d) : suspended(recording) {
+    if (shouldRecord()) {
+        trace.entries.push_back(Entry{operation, {a, b, c, d}});
+    }
+    suspensionDepth += suspended;
+}
+
+TourTrace::Scope::Scope(const std::vector<vertex_t> &tourSequence) : suspended(recording) {
+    if (shouldRecord()) {
+        trace.entries.push_back(Entry{SET_VERTICES, {trace.tourSequences.size(), 0, 0, 0}});
+        trace.tourSequences.push_back(tourSequence);
+    }
+    suspensionDepth += suspended;
+}
+
+TourTrace::Scope::Scope(const AlternatingWalk &alternatingWalk) : suspended(recording) {
+    if (shouldRecord()) {
+        trace.entries.push_back(Entry{EXCHANGE, {trace.alternatingWalks.size(), 0, 0, 0}});
+        trace.alternatingWalks.push_back(alternatingWalk);
+    }
+    suspensionDepth += suspended;
+}
+
+TourTrace::Scope::~Scope() {
+    suspensionDepth -= suspended;
+}
@@ -0,0 +1,67 @@
+#ifndef LINKERNIGHANALGORITHM_TOURTRACE_H
+#define LINKERNIGHANALGORITHM_TOURTRACE_H
+
+#include <cstddef>
+#include <vector>
+#include "Tour.h"
+
+// This namespace records the operations that are performed on tours, so that they can be replayed on a different tour
+// implementation (see TourBenchmark.cpp).
+
+// Just as the instrumentation in Statistics.h the recording is only compiled in when the macro LK_TOUR_TRACE is
+// defined, otherwise the TOUR_TRACE macro at the bottom of this file expands to nothing.
+
+namespace TourTrace {
+    enum Operation {
+        SET_VERTICES, SUCCESSOR, PREDECESSOR, IS_BETWEEN, FLIP, EXCHANGE
+    };
+
+    // A single recorded operation with its arguments
+    // For SET_VERTICES and EXCHANGE the first argument is the index of the tour sequence or alternating walk in the
+    // corresponding vector of the Trace
+    struct Entry {
+        Operation operation;
+        vertex_t arguments[4];
+    };
+
+    // A sequence of operations on a tour
+    struct Trace {
+        std::vector<Entry> entries;
+        std::vector<std::vector<vertex_t>> tourSequences;
+        std::vector<AlternatingWalk> alternatingWalks;
+    };
+
+    // Starts the recording of all operations of the current thread, at most maxEntries entries are recorded
+    void startRecording(std::size_t maxEntries);
+
+    // Stops the recording and returns the recorded trace
+    Trace stopRecording();
+
+    // Records an operation and suspends the recording until it is destroyed, so that operations performed as part of
+    // another operation (e.g. the flips of an exchange) are not recorded
+    class Scope {
+    private:
+        bool suspended;
+
+    public:
+        Scope(Operation operation, vertex_t a, vertex_t b = 0, vertex_t c = 0, vertex_t d = 0);
+
+        explicit Scope(const std::vector<vertex_t> &tourSequence);
+
+        explicit Scope(const AlternatingWalk &alternatingWalk);
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope();
+    };
+}
+
+#ifdef LK_TOUR_TRACE
+#define TOUR_TRACE(...) TourTrace::Scope tourTraceScope(__VA_ARGS__)
+#else
+#define TOUR_TRACE(...) ((void) 0)
+#endif
+
+#endif //LINKERNIGHANALGORITHM_TOURTRACE_H
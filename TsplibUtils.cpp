@@ -2,14 +2,25 @@
 // Created by Karl Welzel on 19.04.2019.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <numeric>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
+#include <sys/mman.h>
+#include "PrimsAlgorithm.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
 #include "TsplibUtils.h"
 
 // Checks if str has the UPPERCASE_WITH_UNDERSCORES format, that all keywords have
@@ -31,7 +42,197 @@ std::string trim(const std::string &str, const std::string &whitespace) {
 
 // ============================================ TsplibProblem class ====================================================
 
-TsplibProblem::TsplibProblem(bool storeAllDistances) : storeAllDistances(storeAllDistances) {
+namespace {
+    // The header at the start of a binary problem file, it is followed directly by the data:
+    // - COORDINATES: dimension * coordinatesPerVertex doubles, the coordinates of each vertex one after another
+    // - LOWER_TRIANGULAR_MATRIX: dimension * (dimension + 1) / 2 distances of type distance_t, the lower triangle of
+    //   the distance matrix including the diagonal row by row
+    // All members have a size that is a multiple of 8 bytes, so the data after the header is aligned.
+    struct BinaryHeader {
+        enum Storage : std::uint32_t {
+            COORDINATES, LOWER_TRIANGULAR_MATRIX
+        };
+
+        char magic[8];
+        // Detects binary files written on a machine with a different byte order
+        std::uint32_t byteOrderMark;
+        std::uint32_t version;
+        Storage storage;
+        std::uint32_t distanceSize;
+        std::uint64_t dimension;
+        std::uint64_t coordinatesPerVertex;
+        char edgeWeightType[16];
+        char name[128];
+    };
+
+    static_assert(sizeof(BinaryHeader) % 8 == 0, "The data after the header must be aligned");
+
+    const char binaryMagic[8] = {'L', 'K', 'T', 'S', 'P', 'B', 'I', 'N'};
+    const std::uint32_t binaryByteOrderMark = 0x01020304;
+    const std::uint32_t binaryVersion = 1;
+
+    // Copy str into the fixed size array destination, the remaining characters are filled with '\0'
+    template<std::size_t size>
+    void copyToArray(const std::string &str, char (&destination)[size]) {
+        std::memset(destination, 0, size);
+        std::memcpy(destination, str.data(), std::min(str.size(), size));
+    }
+
+    // Read a string from a fixed size array that is not necessarily null-terminated
+    template<std::size_t size>
+    std::string copyFromArray(const char (&source)[size]) {
+        return std::string(source, std::find(source, source + size, '\0'));
+    }
+
+    // The names of the EDGE_WEIGHT_TYPEs in the same order as TsplibProblem::EdgeWeightType
+    const char *const edgeWeightTypeNames[] = {"", "EXPLICIT", "EUC_2D", "EUC_3D", "MAX_2D", "MAX_3D", "MAN_2D",
+                                               "MAN_3D", "CEIL_2D", "GEO", "ATT"};
+
+    // The distance functions of the EDGE_WEIGHT_TYPEs with coordinates as defined in the TSPLIB documentation
+    // a and b point to the coordinates of two vertices, for GEO to their latitude and longitude in radians
+    // nint(x) is lround(x), because all distances are non-negative
+
+    distance_t euclidean2D(const double *a, const double *b) {
+        const double dx = a[0] - b[0], dy = a[1] - b[1];
+        return static_cast<distance_t>(std::lround(std::sqrt(dx * dx + dy * dy)));
+    }
+
+    distance_t euclidean3D(const double *a, const double *b) {
+        const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return static_cast<distance_t>(std::lround(std::sqrt(dx * dx + dy * dy + dz * dz)));
+    }
+
+    distance_t maximum2D(const double *a, const double *b) {
+        return static_cast<distance_t>(std::max(std::lround(std::fabs(a[0] - b[0])),
+                                                std::lround(std::fabs(a[1] - b[1]))));
+    }
+
+    distance_t maximum3D(const double *a, const double *b) {
+        return static_cast<distance_t>(std::max(std::max(std::lround(std::fabs(a[0] - b[0])),
+                                                         std::lround(std::fabs(a[1] - b[1]))),
+                                                std::lround(std::fabs(a[2] - b[2]))));
+    }
+
+    distance_t manhattan2D(const double *a, const double *b) {
+        return static_cast<distance_t>(std::lround(std::fabs(a[0] - b[0]) + std::fabs(a[1] - b[1])));
+    }
+
+    distance_t manhattan3D(const double *a, const double *b) {
+        return static_cast<distance_t>(std::lround(std::fabs(a[0] - b[0]) + std::fabs(a[1] - b[1]) +
+                                                   std::fabs(a[2] - b[2])));
+    }
+
+    distance_t ceiling2D(const double *a, const double *b) {
+        const double dx = a[0] - b[0], dy = a[1] - b[1];
+        // ceil(d) returns a double and to prevent errors the result is rounded before casting to distance_t
+        return static_cast<distance_t>(std::lround(std::ceil(std::sqrt(dx * dx + dy * dy))));
+    }
+
+    // The pseudo-Euclidean distance of the att* problems
+    distance_t pseudoEuclidean(const double *a, const double *b) {
+        const double dx = a[0] - b[0], dy = a[1] - b[1];
+        const double r = std::sqrt((dx * dx + dy * dy) / 10.0);
+        const long t = std::lround(r);
+        return static_cast<distance_t>(t < r ? t + 1 : t);
+    }
+
+    // The distance on an idealized sphere, the formula gives 1 for a == b, so this case is handled separately
+    distance_t geographical(const double *a, const double *b) {
+        const double radius = 6378.388;
+        if (a == b) {
+            return 0;
+        }
+        const double q1 = std::cos(a[1] - b[1]);
+        const double q2 = std::cos(a[0] - b[0]);
+        const double q3 = std::cos(a[0] + b[0]);
+        return static_cast<distance_t>(radius * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+    }
+
+    // The matrix is filled in square tiles of this many rows and columns. The rows and columns of a tile and its
+    // mirrored tile fit into the L1 and L2 cache, so the symmetric entry is written while its cache line is loaded
+    const dimension_t matrixTileSize = 64;
+
+    // Matrices with fewer vertices are filled by the calling thread, starting the threads would take longer. Matrices
+    // of subproblems that are created inside a task of a ThreadPool (e.g. the cells of the PartitionedSolver) are
+    // filled by the calling thread as well, the other threads of that pool are busy with their own tasks
+    const dimension_t parallelFillDimension = 1024;
+
+    // Fill the tile with the rows [rowBegin, rowBegin + matrixTileSize) and the columns
+    // [columnBegin, columnBegin + matrixTileSize) of the lower triangle of the matrix with the distances of kernel, the
+    // diagonal is not touched. If triangular is false the mirrored entries of the upper triangle are filled as well,
+    // otherwise only the lower triangle is stored (see TsplibProblem::MatrixLayout)
+    // kernel is a template parameter, so that it is inlined into the loop
+    template<distance_t (*kernel)(const double *, const double *)>
+    void fillMatrixTile(distance_t *entries, dimension_t dimension, const double *coordinates, std::size_t stride,
+                        bool triangular, vertex_t rowBegin, vertex_t columnBegin) {
+        const vertex_t rowEnd = std::min(rowBegin + matrixTileSize, dimension);
+        for (vertex_t i = rowBegin; i < rowEnd; ++i) {
+            const double *a = coordinates + i * stride;
+            const vertex_t columnEnd = std::min(columnBegin + matrixTileSize, i);
+            if (triangular) {
+                distance_t *row = entries + i * (i + 1) / 2;
+                for (vertex_t j = columnBegin; j < columnEnd; ++j) {
+                    row[j] = kernel(a, coordinates + j * stride);
+                }
+            } else {
+                for (vertex_t j = columnBegin; j < columnEnd; ++j) {
+                    entries[i * dimension + j] = entries[j * dimension + i] = kernel(a, coordinates + j * stride);
+                }
+            }
+        }
+    }
+
+    // Fill the matrix with the distances of kernel, every distance is computed only once because all kernels are
+    // symmetric. The tiles of the lower triangle are distributed over a thread pool for large matrices (see
+    // parallelFillDimension)
+    template<distance_t (*kernel)(const double *, const double *)>
+    void fillMatrix(distance_t *entries, dimension_t dimension, const double *coordinates, std::size_t stride,
+                    bool triangular) {
+        const dimension_t numberOfTiles = (dimension + matrixTileSize - 1) / matrixTileSize;
+        const std::size_t numberOfTilePairs = numberOfTiles * (numberOfTiles + 1) / 2;
+
+        // The tile pair with index t is (rowTile, columnTile) with rowTile * (rowTile + 1) / 2 + columnTile = t
+        auto fillTilePair = [=](std::size_t t) {
+            std::size_t rowTile = static_cast<std::size_t>((std::sqrt(8.0 * static_cast<double>(t) + 1) - 1) / 2);
+            // Correct rounding errors of the square root
+            while (rowTile * (rowTile + 1) / 2 > t) --rowTile;
+            while ((rowTile + 1) * (rowTile + 2) / 2 <= t) ++rowTile;
+            const std::size_t columnTile = t - rowTile * (rowTile + 1) / 2;
+            fillMatrixTile<kernel>(entries, dimension, coordinates, stride, triangular, rowTile * matrixTileSize,
+                                   columnTile * matrixTileSize);
+        };
+
+        if (dimension < parallelFillDimension or ThreadPool::isInsideTask()) {
+            for (std::size_t t = 0; t < numberOfTilePairs; ++t) {
+                fillTilePair(t);
+            }
+        } else {
+            ThreadPool threadPool;
+            threadPool.parallelFor(numberOfTilePairs, fillTilePair);
+        }
+    }
+
+    // Allocate count zero-initialized distances with an anonymous memory mapping. Its pages are only backed by memory
+    // when they are first written, so the threads filling the matrix share the work of zeroing them. For large
+    // matrices transparent huge pages are requested, which avoids most TLB misses of the random accesses of the
+    // search. If the mapping fails the distances are allocated with new
+    std::shared_ptr<distance_t> allocateDistances(std::size_t count) {
+        const std::size_t bytes = count * sizeof(distance_t);
+        void *address = bytes == 0 ? MAP_FAILED : mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) {
+            return std::shared_ptr<distance_t>(new distance_t[count](), std::default_delete<distance_t[]>());
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(address, bytes, MADV_HUGEPAGE);
+#endif
+        return std::shared_ptr<distance_t>(static_cast<distance_t *>(address),
+                                           [bytes](distance_t *entries) { munmap(entries, bytes); });
+    }
+}
+
+TsplibProblem::TsplibProblem(bool storeAllDistances, std::size_t distanceCacheBytes)
+        : storeAllDistances(storeAllDistances), distanceCacheBytes(distanceCacheBytes) {
 }
 
 std::string TsplibProblem::interpretKeyword(const std::string &keyword, const std::string &value) {
@@ -47,34 +248,47 @@ std::string TsplibProblem::interpretKeyword(const std::string &keyword, const st
     } else if (keyword == "DIMENSION") {
         dimension = static_cast<dimension_t>(stoi(value));
     } else if (keyword == "EDGE_WEIGHT_TYPE") {
-        edgeWeightType = value;
-        if (edgeWeightType != "EUC_2D" and edgeWeightType != "CEIL_2D" and edgeWeightType != "EXPLICIT") {
-            return "EDGE_WEIGHT_TYPE must be one of: EUC_2D, CEIL_2D, EXPLICIT";
+        if (!setEdgeWeightType(value)) {
+            return "EDGE_WEIGHT_TYPE must be one of: EXPLICIT, EUC_2D, EUC_3D, MAX_2D, MAX_3D, MAN_2D, MAN_3D, "
+                   "CEIL_2D, GEO, ATT";
         }
     } else if (keyword == "EDGE_WEIGHT_FORMAT") {
         edgeWeightFormat = value;
-        if (edgeWeightFormat != "FULL_MATRIX" and edgeWeightFormat != "LOWER_DIAG_ROW" and
-            edgeWeightFormat != "UPPER_DIAG_ROW" and edgeWeightFormat != "UPPER_ROW") {
-            return "EDGE_WEIGHT_FORMAT must be one of: FULL_MATRIX, LOWER_DIAG_ROW, UPPER_DIAG_ROW, UPPER_ROW";
+        if (edgeWeightFormat != "FUNCTION" and edgeWeightFormat != "FULL_MATRIX" and
+            edgeWeightFormat != "LOWER_DIAG_ROW" and edgeWeightFormat != "UPPER_DIAG_ROW" and
+            edgeWeightFormat != "UPPER_ROW") {
+            return "EDGE_WEIGHT_FORMAT must be one of: FUNCTION, FULL_MATRIX, LOWER_DIAG_ROW, UPPER_DIAG_ROW, "
+                   "UPPER_ROW";
         }
     } else if (keyword == "NODE_COORD_TYPE") {
-        nodeCoordType = value;
-        if (nodeCoordType != "TWOD_COORDS") {
-            return "NODE_COORD_TYPE must be TWOD_COORDS";
+        // The number of coordinates per vertex is already given by EDGE_WEIGHT_TYPE
+        if (value != "TWOD_COORDS" and value != "THREED_COORDS") {
+            return "NODE_COORD_TYPE must be TWOD_COORDS or THREED_COORDS";
         }
     } // every unknown keyword is ignored
     return "";
 }
 
 std::string TsplibProblem::readFile(std::ifstream &inputFile) {
+    const std::string content((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    return parse(content.data(), content.data() + content.size());
+}
+
+std::string TsplibProblem::readFile(const MappedFile &inputFile) {
+    return parse(inputFile.data(), inputFile.data() + inputFile.size());
+}
+
+std::string TsplibProblem::parse(const char *begin, const char *end) {
+    STATISTICS_TIMER(PARSING);
+
+    Scanner scanner(begin, end);
     std::string line;
     std::string lastDataKeyword;
     std::string::size_type delimiterIndex;
-    std::vector<distance_t> numbers; // All numbers in the TSPLIB file as they appear in EDGE_WEIGHT_SECTION
+    bool edgeWeightSectionRead = false;
 
-    while (inputFile) {
-        getline(inputFile, line);
-        line = trim(line);
+    while (!scanner.atEnd()) {
+        line = scanner.readLine();
         if (line.empty()) {
             // ignore empty lines
         } else if ((delimiterIndex = line.find(DELIMITER)) != std::string::npos) {
@@ -93,44 +307,28 @@ std::string TsplibProblem::readFile(std::ifstream &inputFile) {
                 if (line == "EOF") {
                     break;
                 } else if (line == "NODE_COORD_SECTION") {
-                    if (edgeWeightType != "EUC_2D" and edgeWeightType != "EUC_3D" and edgeWeightType != "MAX_2D" and
-                        edgeWeightType != "MAX_3D" and edgeWeightType != "MAN_2D" and edgeWeightType != "MAN_3D" and
-                        edgeWeightType != "CEIL_2D" and edgeWeightType != "GEO") {
+                    if (edgeWeightType == UNSPECIFIED or edgeWeightType == EXPLICIT) {
                         return "NODE_COORD_SECTION encountered, but EDGE_WEIGHT_TYPE is not one of: EUC_2D, EUC_3D, "
-                               "MAX_2D, MAX_3D, MAN_2D, MAN_3D, CEIL_2D, GEO";
+                               "MAX_2D, MAX_3D, MAN_2D, MAN_3D, CEIL_2D, GEO, ATT";
+                    }
+                    const std::string errorMessage = readNodeCoordSection(scanner);
+                    if (!errorMessage.empty()) {
+                        return errorMessage;
                     }
-                    // Initialize coordinates with dimension empty vectors
-                    coordinates.resize(dimension);
                 } else if (line == "EDGE_WEIGHT_SECTION") {
-                    if (edgeWeightType != "EXPLICIT") {
+                    if (edgeWeightType != EXPLICIT) {
                         return "EDGE_WEIGHT_SECTION encountered, but EDGE_WEIGHT_TYPE is not EXPLICIT";
                     }
-                }
-            } else {
-                if (lastDataKeyword == "NODE_COORD_SECTION") {
-                    // Already checked: nodeCoordType == "TWOD_COORDS"
-                    // Every line has the format <integer> <real> <real>
-                    std::stringstream stream(line);
-                    vertex_t n = 0;
-                    double x = 0, y = 0;
-                    stream >> n >> x >> y;
-                    try {
-                        coordinates.at(n - 1) = {x, y};
-                    } catch (std::out_of_range &error) {
-                        return "One of the coordinates has a number outside of the range [1, DIMENSION]";
-                    }
-                } else if (lastDataKeyword == "EDGE_WEIGHT_SECTION") {
-                    // Every line is a sequence of integers separated by whitespaces
-                    std::stringstream stream(line);
-                    distance_t n;
-                    while (stream >> n) {
-                        numbers.push_back(n);
+                    const std::string errorMessage = readEdgeWeightSection(scanner);
+                    if (!errorMessage.empty()) {
+                        return errorMessage;
                     }
-                } else if (!lastDataKeyword.empty()) {
-                    // lastDataKeyword is unknown, so this block of data will be skipped
-                } else {
-                    return "Encountered data when expecting a keyword";
+                    edgeWeightSectionRead = true;
                 }
+            } else if (!lastDataKeyword.empty()) {
+                // lastDataKeyword is unknown, so this block of data will be skipped
+            } else {
+                return "Encountered data when expecting a keyword";
             }
         }
     }
@@ -139,75 +337,340 @@ std::string TsplibProblem::readFile(std::ifstream &inputFile) {
     if (dimension == 0) {
         return "The dimension cannot be 0";
     }
-    if (edgeWeightType.empty()) {
+    if (edgeWeightType == UNSPECIFIED) {
         return "EDGE_WEIGHT_TYPE must be specified";
     }
 
-    if (edgeWeightType == "EXPLICIT" and edgeWeightFormat.empty()) {
+    if (edgeWeightType == EXPLICIT and edgeWeightFormat.empty()) {
         return "When EDGE_WEIGHT_TYPE is EXPLICIT, EDGE_WEIGHT_FORMAT must be specified";
     }
+    if (edgeWeightType == EXPLICIT and !edgeWeightSectionRead) {
+        return "Too few numbers were specified under EDGE_WEIGHT_SECTION";
+    }
 
-    if (edgeWeightType == "EUC_2D" or edgeWeightType == "MAX_2D" or edgeWeightType == "MAN_2D"
-        or edgeWeightType == "CEIL_2D") {
-        for (const std::vector<double> &coord : coordinates) {
-            if (coord.size() != 2) {
-                return "Too few coordinates were specified or the coordinates have the wrong dimension "
-                       "(3D instead of 2D)";
+    if (edgeWeightType != EXPLICIT) {
+        if (coordinates.size() != dimension * coordinatesPerVertex) {
+            return "Too few coordinates were specified";
+        }
+        // An explicit matrix was already filled while parsing
+        prepareDistances();
+    }
+
+    return "";
+}
+
+std::string TsplibProblem::readNodeCoordSection(Scanner &scanner) {
+    // Every line has the format <integer> <real> <real> (<real>), where the number of reals is coordinatesPerVertex
+    // The section ends with the next keyword
+    coordinates.assign(dimension * coordinatesPerVertex, 0);
+    std::vector<bool> specified(dimension, false);
+    dimension_t numberOfSpecified = 0;
+    while (true) {
+        scanner.skipWhitespace();
+        if (scanner.atEnd() or scanner.atLetter()) {
+            break;
+        }
+        vertex_t n = 0;
+        if (!scanner.parseUnsigned(n)) {
+            return "Expected a vertex number at the start of a line in NODE_COORD_SECTION";
+        }
+        if (n < 1 or n > dimension) {
+            return "One of the coordinates has a number outside of the range [1, DIMENSION]";
+        }
+        for (std::size_t c = 0; c < coordinatesPerVertex; ++c) {
+            if (!scanner.parseDouble(coordinates[(n - 1) * coordinatesPerVertex + c])) {
+                return "Expected " + std::to_string(coordinatesPerVertex) + " coordinates for every vertex in "
+                                                                            "NODE_COORD_SECTION";
             }
         }
+        if (!specified[n - 1]) {
+            specified[n - 1] = true;
+            numberOfSpecified++;
+        }
+        scanner.readLine(); // Ignore the rest of the line
+    }
+    if (numberOfSpecified != dimension) {
+        return "Too few coordinates were specified";
     }
+    return "";
+}
 
-    // Fill the matrix of distances properly
-    if (edgeWeightType == "EXPLICIT") {
-        // Initialize the matrix with zeros
-        matrix.assign(dimension, std::vector<distance_t>(dimension, 0));
-        try {
-            std::size_t numbersIndex = 0;
-            if (edgeWeightFormat == "FULL_MATRIX") {
-                for (vertex_t i = 0; i < dimension; ++i) {
-                    for (vertex_t j = 0; j < dimension; ++j) {
-                        matrix[i][j] = numbers.at(numbersIndex);
-                        numbersIndex++;
-                    }
-                }
-            } else if (edgeWeightFormat == "LOWER_DIAG_ROW") {
-                for (vertex_t i = 0; i < dimension; ++i) {
-                    for (vertex_t j = 0; j <= i; ++j) {
-                        matrix[i][j] = matrix[j][i] = numbers.at(numbersIndex);
-                        numbersIndex++;
-                    }
-                }
-            } else if (edgeWeightFormat == "UPPER_DIAG_ROW") {
-                for (vertex_t i = 0; i < dimension; ++i) {
-                    for (vertex_t j = i; j < dimension; ++j) {
-                        matrix[i][j] = matrix[j][i] = numbers.at(numbersIndex);
-                        numbersIndex++;
-                    }
-                }
-            } else if (edgeWeightFormat == "UPPER_ROW") {
-                // The diagonal is never touched, so it is filled with zeros from the initialization
-                for (vertex_t i = 0; i < dimension; ++i) {
-                    for (vertex_t j = i + 1; j < dimension; ++j) {
-                        matrix[i][j] = matrix[j][i] = numbers.at(numbersIndex);
-                        numbersIndex++;
-                    }
+std::string TsplibProblem::readEdgeWeightSection(Scanner &scanner) {
+    if (dimension == 0 or edgeWeightFormat.empty()) {
+        return "DIMENSION and EDGE_WEIGHT_FORMAT must be specified before EDGE_WEIGHT_SECTION";
+    }
+    if (edgeWeightFormat == "FUNCTION") {
+        return "EDGE_WEIGHT_SECTION encountered, but EDGE_WEIGHT_FORMAT is FUNCTION";
+    }
+    // Every line is a sequence of integers separated by whitespaces, they are written directly into the matrix
+    STATISTICS_TIMER(MATRIX_FILL);
+    distance_t *entries = allocateFullMatrix();
+    const std::string tooFewNumbers = "Too few numbers were specified under EDGE_WEIGHT_SECTION";
+    distance_t value;
+    if (edgeWeightFormat == "FULL_MATRIX") {
+        for (std::size_t index = 0; index < dimension * dimension; ++index) {
+            if (!scanner.parseUnsigned(entries[index])) {
+                return tooFewNumbers;
+            }
+        }
+    } else if (edgeWeightFormat == "LOWER_DIAG_ROW") {
+        for (vertex_t i = 0; i < dimension; ++i) {
+            for (vertex_t j = 0; j <= i; ++j) {
+                if (!scanner.parseUnsigned(value)) {
+                    return tooFewNumbers;
                 }
+                entries[i * dimension + j] = entries[j * dimension + i] = value;
             }
-            if (numbersIndex < numbers.size()) {
-                return "Too many numbers were specified under EDGE_WEIGHT_SECTION";
+        }
+    } else if (edgeWeightFormat == "UPPER_DIAG_ROW") {
+        for (vertex_t i = 0; i < dimension; ++i) {
+            for (vertex_t j = i; j < dimension; ++j) {
+                if (!scanner.parseUnsigned(value)) {
+                    return tooFewNumbers;
+                }
+                entries[i * dimension + j] = entries[j * dimension + i] = value;
             }
-        } catch (std::out_of_range &error) {
-            return "Too few numbers were specified under EDGE_WEIGHT_SECTION";
         }
-    } else if (storeAllDistances) {
-        matrix.assign(dimension, std::vector<distance_t>(dimension, 0));
+    } else if (edgeWeightFormat == "UPPER_ROW") {
+        // The diagonal is never touched, so it is filled with zeros from the initialization
         for (vertex_t i = 0; i < dimension; ++i) {
-            for (vertex_t j = 0; j < dimension; ++j) {
-                matrix[i][j] = trueDistance(i, j);
+            for (vertex_t j = i + 1; j < dimension; ++j) {
+                if (!scanner.parseUnsigned(value)) {
+                    return tooFewNumbers;
+                }
+                entries[i * dimension + j] = entries[j * dimension + i] = value;
             }
         }
     }
+    scanner.skipWhitespace();
+    if (scanner.parseUnsigned(value)) {
+        return "Too many numbers were specified under EDGE_WEIGHT_SECTION";
+    }
+    return "";
+}
+
+distance_t *TsplibProblem::allocateFullMatrix() {
+    std::shared_ptr<distance_t> entries = allocateDistances(dimension * dimension);
+    matrix = entries;
+    matrixLayout = FULL;
+    return entries.get();
+}
 
+distance_t *TsplibProblem::allocateTriangularMatrix() {
+    std::shared_ptr<distance_t> entries = allocateDistances(dimension * (dimension + 1) / 2);
+    matrix = entries;
+    matrixLayout = LOWER_TRIANGULAR;
+    return entries.get();
+}
+
+bool TsplibProblem::setEdgeWeightType(const std::string &edgeWeightTypeName) {
+    for (int i = EXPLICIT; i <= ATT; ++i) {
+        if (edgeWeightTypeName == edgeWeightTypeNames[i]) {
+            edgeWeightType = static_cast<EdgeWeightType>(i);
+            coordinatesPerVertex = (edgeWeightType == EUC_3D or edgeWeightType == MAX_3D or edgeWeightType == MAN_3D)
+                                   ? 3 : 2;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TsplibProblem::prepareDistances() {
+    if (edgeWeightType == GEO) {
+        // The coordinates have the format DDD.MM with degrees DDD and minutes MM, the latitude is the first coordinate
+        const double pi = 3.141592; // The value used by the TSPLIB documentation
+        geoRadians.resize(2 * dimension);
+        for (std::size_t index = 0; index < 2 * dimension; ++index) {
+            const double degrees = static_cast<double>(static_cast<long>(coordinates[index]));
+            const double minutes = coordinates[index] - degrees;
+            geoRadians[index] = pi * (degrees + 5.0 * minutes / 3.0) / 180.0;
+        }
+    }
+
+    if (storeAllDistances) {
+        STATISTICS_TIMER(MATRIX_FILL);
+        computeAllDistances();
+    } else if (distanceCacheBytes > 0) {
+        distanceCache = std::make_shared<DistanceCache>(dimension, distanceCacheBytes);
+    }
+}
+
+void TsplibProblem::setDistanceStorage(bool storeAllDistances, std::size_t distanceCacheBytes,
+                                       bool triangularMatrix) {
+    if (edgeWeightType == EXPLICIT) {
+        return;
+    }
+    this->storeAllDistances = storeAllDistances;
+    this->distanceCacheBytes = distanceCacheBytes;
+    this->triangularMatrix = triangularMatrix;
+
+    // Release the old storage before the new one is allocated
+    matrix.reset();
+    distanceCache.reset();
+    prepareDistances();
+}
+
+void TsplibProblem::computeAllDistances() {
+    distance_t *entries = triangularMatrix ? allocateTriangularMatrix() : allocateFullMatrix();
+    const double *values = coordinates.data();
+    const std::size_t stride = coordinatesPerVertex;
+    switch (edgeWeightType) {
+        case EUC_2D:
+            fillMatrix<euclidean2D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case EUC_3D:
+            fillMatrix<euclidean3D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case MAX_2D:
+            fillMatrix<maximum2D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case MAX_3D:
+            fillMatrix<maximum3D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case MAN_2D:
+            fillMatrix<manhattan2D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case MAN_3D:
+            fillMatrix<manhattan3D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case CEIL_2D:
+            fillMatrix<ceiling2D>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case ATT:
+            fillMatrix<pseudoEuclidean>(entries, dimension, values, stride, triangularMatrix);
+            break;
+        case GEO:
+            fillMatrix<geographical>(entries, dimension, geoRadians.data(), 2, triangularMatrix);
+            break;
+        default:
+            throw std::runtime_error("The distances of the EDGE_WEIGHT_TYPE '" +
+                                     std::string(getName(edgeWeightType)) + "' cannot be computed.");
+    }
+}
+
+TsplibProblem TsplibProblem::fromCoordinates(std::string name, EdgeWeightType edgeWeightType,
+                                             const std::vector<std::vector<double>> &coordinates,
+                                             bool storeAllDistances) {
+    TsplibProblem problem(storeAllDistances);
+    problem.name = std::move(name);
+    problem.type = "TSP";
+    problem.dimension = coordinates.size();
+    problem.setEdgeWeightType(getName(edgeWeightType));
+    problem.coordinates.reserve(problem.dimension * problem.coordinatesPerVertex);
+    for (const std::vector<double> &coord : coordinates) {
+        problem.coordinates.insert(problem.coordinates.end(), coord.begin(),
+                                   coord.begin() + static_cast<std::ptrdiff_t>(problem.coordinatesPerVertex));
+    }
+    problem.prepareDistances();
+    return problem;
+}
+
+bool TsplibProblem::isBinaryFile(const MappedFile &inputFile) {
+    return inputFile.size() >= sizeof(binaryMagic) and
+           std::memcmp(inputFile.data(), binaryMagic, sizeof(binaryMagic)) == 0;
+}
+
+std::string TsplibProblem::readBinaryFile(MappedFile inputFile) {
+    STATISTICS_TIMER(PARSING);
+
+    BinaryHeader header{};
+    if (!isBinaryFile(inputFile) or inputFile.size() < sizeof(BinaryHeader)) {
+        return "The file is not a binary problem file";
+    }
+    std::memcpy(&header, inputFile.data(), sizeof(BinaryHeader));
+    if (header.byteOrderMark != binaryByteOrderMark) {
+        return "The binary problem file was written on a machine with a different byte order";
+    }
+    if (header.version != binaryVersion) {
+        return "The version of the binary problem file is not supported";
+    }
+    if (header.distanceSize != sizeof(distance_t)) {
+        return "The binary problem file was written with a different size of distances";
+    }
+    // The matrix of a larger dimension would not fit into the address space, so such a header is corrupt. The bound
+    // also keeps the sizes computed from the dimension below from overflowing
+    const auto maxDimension = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(SIZE_MAX / sizeof(distance_t))));
+    if (header.dimension > maxDimension) {
+        return "The dimension of the binary problem file is too large";
+    }
+
+    name = copyFromArray(header.name);
+    type = "TSP";
+    dimension = header.dimension;
+    if (!setEdgeWeightType(copyFromArray(header.edgeWeightType))) {
+        return "The EDGE_WEIGHT_TYPE of the binary problem file is not supported";
+    }
+    if (dimension == 0) {
+        return "The dimension cannot be 0";
+    }
+
+    const char *data = inputFile.data() + sizeof(BinaryHeader);
+    const std::size_t dataSize = inputFile.size() - sizeof(BinaryHeader);
+    if (header.storage == BinaryHeader::LOWER_TRIANGULAR_MATRIX) {
+        if (edgeWeightType != EXPLICIT) {
+            return "A binary problem file with a matrix must have the EDGE_WEIGHT_TYPE EXPLICIT";
+        }
+        if (dataSize % sizeof(distance_t) != 0 or dataSize / sizeof(distance_t) != dimension * (dimension + 1) / 2) {
+            return "The size of the binary problem file does not fit to the dimension";
+        }
+        // The matrix is used directly from the mapped file, which stays mapped as long as the matrix is used
+        auto file = std::make_shared<MappedFile>(std::move(inputFile));
+        file->adviseRandomAccess();
+        matrix = std::shared_ptr<const distance_t>(file, reinterpret_cast<const distance_t *>(data));
+        matrixLayout = LOWER_TRIANGULAR;
+    } else if (header.storage == BinaryHeader::COORDINATES) {
+        if (edgeWeightType == EXPLICIT or header.coordinatesPerVertex != coordinatesPerVertex) {
+            return "The number of coordinates in the binary problem file does not fit to the EDGE_WEIGHT_TYPE";
+        }
+        if (dataSize % sizeof(double) != 0 or dataSize / sizeof(double) != dimension * coordinatesPerVertex) {
+            return "The size of the binary problem file does not fit to the dimension";
+        }
+        const double *values = reinterpret_cast<const double *>(data);
+        coordinates.assign(values, values + dimension * coordinatesPerVertex);
+        prepareDistances();
+    } else {
+        return "The storage of the binary problem file is unknown";
+    }
+    return "";
+}
+
+std::string TsplibProblem::writeBinaryFile(const std::string &fileName) const {
+    BinaryHeader header{};
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.byteOrderMark = binaryByteOrderMark;
+    header.version = binaryVersion;
+    header.distanceSize = sizeof(distance_t);
+    header.dimension = dimension;
+    copyToArray(getName(edgeWeightType), header.edgeWeightType);
+    copyToArray(name, header.name);
+
+    std::ofstream outputFile(fileName, std::ios::binary);
+    if (!outputFile) {
+        return "Could not open the file '" + fileName + "'";
+    }
+    if (edgeWeightType == EXPLICIT) {
+        header.storage = BinaryHeader::LOWER_TRIANGULAR_MATRIX;
+        header.coordinatesPerVertex = 0;
+        outputFile.write(reinterpret_cast<const char *>(&header), sizeof(BinaryHeader));
+        std::vector<distance_t> row;
+        for (vertex_t i = 0; i < dimension; ++i) {
+            row.clear();
+            for (vertex_t j = 0; j <= i; ++j) {
+                row.push_back(matrixEntry(i, j));
+            }
+            outputFile.write(reinterpret_cast<const char *>(row.data()),
+                             static_cast<std::streamsize>(row.size() * sizeof(distance_t)));
+        }
+    } else {
+        header.storage = BinaryHeader::COORDINATES;
+        header.coordinatesPerVertex = coordinatesPerVertex;
+        outputFile.write(reinterpret_cast<const char *>(&header), sizeof(BinaryHeader));
+        outputFile.write(reinterpret_cast<const char *>(coordinates.data()),
+                         static_cast<std::streamsize>(coordinates.size() * sizeof(double)));
+    }
+    if (!outputFile) {
+        return "Could not write the file '" + fileName + "'";
+    }
     return "";
 }
 
@@ -223,31 +686,491 @@ dimension_t TsplibProblem::getDimension() const {
     return dimension;
 }
 
-distance_t TsplibProblem::trueDistance(vertex_t i, vertex_t j) const {
-    if (edgeWeightType == "EUC_2D") {
-        double d = hypot(coordinates[i][0] - coordinates[j][0],
-                         coordinates[i][1] - coordinates[j][1]);
-        return static_cast<distance_t>(lround(d)); // lround(d) >= 0, so casting does not produce any errors
-    } else if (edgeWeightType == "CEIL_2D") {
-        double d = hypot(coordinates[i][0] - coordinates[j][0],
-                         coordinates[i][1] - coordinates[j][1]);
-        // ceil(d) returns a double and to prevent errors the result is rounded before casting to distance_t
-        return static_cast<distance_t>(lround(ceil(d)));
-    } else if (edgeWeightType == "EXPLICIT") {
-        return matrix[i][j];
+TsplibProblem::EdgeWeightType TsplibProblem::getEdgeWeightType() const {
+    return edgeWeightType;
+}
+
+std::size_t TsplibProblem::getMatrixBytes() const {
+    if (!matrix) {
+        return 0;
+    } else if (matrixLayout == FULL) {
+        return dimension * dimension * sizeof(distance_t);
     } else {
-        throw std::runtime_error("The EDGE_WEIGHT_TYPE '" + edgeWeightType + "' is not supported.");
+        return dimension * (dimension + 1) / 2 * sizeof(distance_t);
+    }
+}
+
+const char *TsplibProblem::getName(EdgeWeightType edgeWeightType) {
+    return edgeWeightTypeNames[edgeWeightType];
+}
+
+distance_t TsplibProblem::trueDistance(vertex_t i, vertex_t j) const {
+    const double *values = coordinates.data();
+    const std::size_t stride = coordinatesPerVertex;
+    switch (edgeWeightType) {
+        case EXPLICIT:
+            return matrixEntry(i, j);
+        case EUC_2D:
+            return euclidean2D(values + i * stride, values + j * stride);
+        case EUC_3D:
+            return euclidean3D(values + i * stride, values + j * stride);
+        case MAX_2D:
+            return maximum2D(values + i * stride, values + j * stride);
+        case MAX_3D:
+            return maximum3D(values + i * stride, values + j * stride);
+        case MAN_2D:
+            return manhattan2D(values + i * stride, values + j * stride);
+        case MAN_3D:
+            return manhattan3D(values + i * stride, values + j * stride);
+        case CEIL_2D:
+            return ceiling2D(values + i * stride, values + j * stride);
+        case ATT:
+            return pseudoEuclidean(values + i * stride, values + j * stride);
+        case GEO:
+            return geographical(geoRadians.data() + 2 * i, geoRadians.data() + 2 * j);
+        default:
+            throw std::runtime_error("The EDGE_WEIGHT_TYPE '" + std::string(getName(edgeWeightType)) +
+                                     "' is not supported.");
     }
 }
 
 distance_t TsplibProblem::dist(const vertex_t i, const vertex_t j) const {
+    STATISTICS_COUNT(DIST_CALLS);
     if (storeAllDistances) {
-        return matrix[i][j];
+        return matrixEntry(i, j);
+    } else if (distanceCache) {
+        return distanceCache->get(i, j, [this](vertex_t v, vertex_t w) { return trueDistance(v, w); });
     } else {
         return trueDistance(i, j);
     }
 }
 
+void TsplibProblem::cacheNeighborDistances(const std::vector<std::vector<vertex_t>> &neighbors) {
+    if (distanceCache) {
+        distanceCache->setNeighbors(neighbors, [this](vertex_t v, vertex_t w) { return trueDistance(v, w); });
+    }
+}
+
+std::vector<vertex_t> TsplibProblem::localityOrder() const {
+    std::vector<vertex_t> order;
+    order.reserve(dimension);
+
+    if (edgeWeightType == EXPLICIT) {
+        // A depth-first search of a minimum spanning tree visits the children of a vertex in the order of Prim's
+        // algorithm, so the subtree of the nearest child comes first
+        std::vector<vertex_t> parent;
+        std::vector<vertex_t> topologicalOrder;
+        std::tie(parent, topologicalOrder) = primsAlgorithm(dimension, [this](vertex_t i, vertex_t j) {
+            return static_cast<signed_distance_t>(dist(i, j));
+        });
+
+        std::vector<std::vector<vertex_t>> children(dimension);
+        for (auto v = topologicalOrder.begin() + 1; v != topologicalOrder.end(); ++v) {
+            children[parent[*v]].push_back(*v);
+        }
+        std::vector<vertex_t> stack{topologicalOrder.front()};
+        while (!stack.empty()) {
+            const vertex_t v = stack.back();
+            stack.pop_back();
+            order.push_back(v);
+            stack.insert(stack.end(), children[v].rbegin(), children[v].rend());
+        }
+        return order;
+    }
+
+    // Map the first two coordinates of every vertex to a grid with 2^bits cells in both directions, the aspect ratio
+    // is kept
+    const unsigned int bits = 20;
+    const std::uint32_t gridSize = 1u << bits;
+    double minimum[2] = {coordinates[0], coordinates[1]};
+    double maximum[2] = {coordinates[0], coordinates[1]};
+    for (vertex_t v = 0; v < dimension; ++v) {
+        for (std::size_t c = 0; c < 2; ++c) {
+            minimum[c] = std::min(minimum[c], coordinates[v * coordinatesPerVertex + c]);
+            maximum[c] = std::max(maximum[c], coordinates[v * coordinatesPerVertex + c]);
+        }
+    }
+    const double extent = std::max(maximum[0] - minimum[0], maximum[1] - minimum[1]);
+    const double scale = extent > 0 ? (gridSize - 1) / extent : 0;
+
+    // The index of every vertex on the Hilbert curve through the grid, see the conversion from (x, y) to d on
+    // https://en.wikipedia.org/wiki/Hilbert_curve
+    std::vector<std::uint64_t> hilbertIndex(dimension);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        auto x = static_cast<std::uint32_t>((coordinates[v * coordinatesPerVertex] - minimum[0]) * scale);
+        auto y = static_cast<std::uint32_t>((coordinates[v * coordinatesPerVertex + 1] - minimum[1]) * scale);
+        std::uint64_t index = 0;
+        for (std::uint32_t s = gridSize / 2; s > 0; s /= 2) {
+            const std::uint32_t rx = (x & s) ? 1 : 0;
+            const std::uint32_t ry = (y & s) ? 1 : 0;
+            index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // Rotate the quadrant, so that the curve inside it has the right orientation
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = gridSize - 1 - x;
+                    y = gridSize - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        hilbertIndex[v] = index;
+    }
+
+    for (vertex_t v = 0; v < dimension; ++v) {
+        order.push_back(v);
+    }
+    std::stable_sort(order.begin(), order.end(), [&hilbertIndex](vertex_t v, vertex_t w) {
+        return hilbertIndex[v] < hilbertIndex[w];
+    });
+    return order;
+}
+
+std::vector<std::vector<vertex_t>> TsplibProblem::gridNearestNeighbors(std::size_t k) const {
+    if (edgeWeightType == EXPLICIT or edgeWeightType == GEO) {
+        return {};
+    }
+    k = std::min<std::size_t>(k, dimension - 1);
+
+    // Square cells with about two vertices each over the bounding box of the first two coordinates
+    double minimum[2] = {coordinates[0], coordinates[1]};
+    double maximum[2] = {coordinates[0], coordinates[1]};
+    for (vertex_t v = 0; v < dimension; ++v) {
+        for (std::size_t c = 0; c < 2; ++c) {
+            minimum[c] = std::min(minimum[c], coordinates[v * coordinatesPerVertex + c]);
+            maximum[c] = std::max(maximum[c], coordinates[v * coordinatesPerVertex + c]);
+        }
+    }
+    // The second bound keeps the number of cells linear when all vertices are (almost) on a line
+    const double width = maximum[0] - minimum[0], height = maximum[1] - minimum[1];
+    double side = std::max(std::sqrt(2.0 * width * height / dimension), 2.0 * std::max(width, height) / dimension);
+    if (side <= 0) {
+        side = 1.0;
+    }
+    const auto columns = static_cast<std::size_t>(width / side) + 1;
+    const auto rows = static_cast<std::size_t>(height / side) + 1;
+    auto cellOf = [&](vertex_t v) {
+        const auto x = static_cast<std::size_t>((coordinates[v * coordinatesPerVertex] - minimum[0]) / side);
+        const auto y = static_cast<std::size_t>((coordinates[v * coordinatesPerVertex + 1] - minimum[1]) / side);
+        return std::make_pair(std::min(x, columns - 1), std::min(y, rows - 1));
+    };
+
+    // Sort the vertices by their cell, the vertices of cell (x, y) are cellVertices[cellStart[i]], ...,
+    // cellVertices[cellStart[i + 1] - 1] with i = y * columns + x
+    std::vector<std::size_t> cellStart(columns * rows + 1, 0);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        const auto cell = cellOf(v);
+        ++cellStart[cell.second * columns + cell.first + 1];
+    }
+    std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+    std::vector<vertex_t> cellVertices(dimension);
+    std::vector<std::size_t> nextPosition(cellStart.begin(), cellStart.end() - 1);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        const auto cell = cellOf(v);
+        cellVertices[nextPosition[cell.second * columns + cell.first]++] = v;
+    }
+
+    // A vertex outside of the first r rings around the cell of v differs from v by at least r * side in one of the
+    // first two coordinates. Every supported distance is at least this difference rounded to the nearest integer,
+    // only the pseudo-Euclidean distance divides it by sqrt(10) first
+    const double boundScale = edgeWeightType == ATT ? 1.0 / std::sqrt(10.0) : 1.0;
+    const std::size_t maxRing = std::max(columns, rows);
+
+    std::vector<std::vector<vertex_t>> neighbors(dimension);
+    std::vector<std::pair<distance_t, vertex_t>> heap;
+    for (vertex_t v = 0; v < dimension; ++v) {
+        heap.clear();
+        const auto cell = cellOf(v);
+        const auto x = static_cast<long>(cell.first), y = static_cast<long>(cell.second);
+        for (std::size_t ring = 0; ring <= maxRing; ++ring) {
+            const auto r = static_cast<long>(ring);
+            for (long cy = y - r; cy <= y + r; ++cy) {
+                if (cy < 0 or cy >= static_cast<long>(rows)) {
+                    continue;
+                }
+                // Only the border of the ring, the inner cells were searched before
+                const long step = (cy == y - r or cy == y + r) ? 1 : std::max(2 * r, 1L);
+                for (long cx = x - r; cx <= x + r; cx += step) {
+                    if (cx < 0 or cx >= static_cast<long>(columns)) {
+                        continue;
+                    }
+                    const std::size_t index = static_cast<std::size_t>(cy) * columns + static_cast<std::size_t>(cx);
+                    for (std::size_t i = cellStart[index]; i < cellStart[index + 1]; ++i) {
+                        const vertex_t w = cellVertices[i];
+                        if (w == v) {
+                            continue;
+                        }
+                        const distance_t distance = trueDistance(v, w);
+                        if (heap.size() < k) {
+                            heap.emplace_back(distance, w);
+                            std::push_heap(heap.begin(), heap.end());
+                        } else if (k > 0 and std::make_pair(distance, w) < heap.front()) {
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = std::make_pair(distance, w);
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                    }
+                }
+            }
+            if (heap.size() == k and (k == 0 or heap.front().first + 0.5 <= boundScale * r * side)) {
+                break;
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end());
+        neighbors[v].reserve(heap.size());
+        for (const auto &entry : heap) {
+            neighbors[v].push_back(entry.second);
+        }
+    }
+    return neighbors;
+}
+
+std::vector<std::vector<vertex_t>> TsplibProblem::partition(dimension_t maxCellSize) const {
+    std::vector<std::vector<vertex_t>> cells;
+    const std::vector<vertex_t> order = localityOrder();
+    if (edgeWeightType == EXPLICIT) {
+        // Cut the order into parts of equal size
+        const std::size_t numberOfCells = (dimension + maxCellSize - 1) / maxCellSize;
+        for (std::size_t c = 0; c < numberOfCells; ++c) {
+            cells.emplace_back(order.begin() + static_cast<std::ptrdiff_t>(c * dimension / numberOfCells),
+                               order.begin() + static_cast<std::ptrdiff_t>((c + 1) * dimension / numberOfCells));
+        }
+        return cells;
+    }
+
+    // Every vertex range [first, last) of vertices on the stack is a cell that may still be too large
+    std::vector<vertex_t> vertices(dimension);
+    std::iota(vertices.begin(), vertices.end(), 0);
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{0, dimension}};
+    while (!stack.empty()) {
+        const std::size_t first = stack.back().first;
+        const std::size_t last = stack.back().second;
+        stack.pop_back();
+        if (last - first <= maxCellSize) {
+            cells.emplace_back(vertices.begin() + static_cast<std::ptrdiff_t>(first),
+                               vertices.begin() + static_cast<std::ptrdiff_t>(last));
+            continue;
+        }
+
+        double minimum[2] = {coordinates[vertices[first] * coordinatesPerVertex],
+                             coordinates[vertices[first] * coordinatesPerVertex + 1]};
+        double maximum[2] = {minimum[0], minimum[1]};
+        for (std::size_t i = first; i < last; ++i) {
+            for (std::size_t c = 0; c < 2; ++c) {
+                minimum[c] = std::min(minimum[c], coordinates[vertices[i] * coordinatesPerVertex + c]);
+                maximum[c] = std::max(maximum[c], coordinates[vertices[i] * coordinatesPerVertex + c]);
+            }
+        }
+        const std::size_t c = maximum[0] - minimum[0] >= maximum[1] - minimum[1] ? 0 : 1;
+        const std::size_t middle = first + (last - first) / 2;
+        std::nth_element(vertices.begin() + static_cast<std::ptrdiff_t>(first),
+                         vertices.begin() + static_cast<std::ptrdiff_t>(middle),
+                         vertices.begin() + static_cast<std::ptrdiff_t>(last), [this, c](vertex_t v, vertex_t w) {
+                    return coordinates[v * coordinatesPerVertex + c] < coordinates[w * coordinatesPerVertex + c];
+                });
+        stack.emplace_back(first, middle);
+        stack.emplace_back(middle, last);
+    }
+
+    // Order the cells by the mean position of their vertices in order
+    const std::vector<std::size_t> position = BaseTour::inversePermutation(order);
+    std::vector<double> meanPosition(cells.size(), 0);
+    for (std::size_t c = 0; c < cells.size(); ++c) {
+        for (vertex_t v : cells[c]) {
+            meanPosition[c] += static_cast<double>(position[v]) / static_cast<double>(cells[c].size());
+        }
+    }
+    std::vector<std::size_t> cellOrder(cells.size());
+    std::iota(cellOrder.begin(), cellOrder.end(), 0);
+    std::sort(cellOrder.begin(), cellOrder.end(), [&meanPosition](std::size_t c1, std::size_t c2) {
+        return meanPosition[c1] < meanPosition[c2];
+    });
+    std::vector<std::vector<vertex_t>> orderedCells;
+    orderedCells.reserve(cells.size());
+    for (std::size_t c : cellOrder) {
+        orderedCells.push_back(std::move(cells[c]));
+    }
+    return orderedCells;
+}
+
+TsplibProblem TsplibProblem::subproblem(const std::vector<vertex_t> &vertices, bool storeAllDistances) const {
+    TsplibProblem problem(storeAllDistances);
+    problem.name = name;
+    problem.type = type;
+    problem.dimension = vertices.size();
+    problem.edgeWeightType = edgeWeightType;
+    problem.edgeWeightFormat = edgeWeightFormat;
+    problem.coordinatesPerVertex = coordinatesPerVertex;
+    if (edgeWeightType == EXPLICIT) {
+        distance_t *entries = problem.allocateFullMatrix();
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            for (std::size_t j = 0; j < vertices.size(); ++j) {
+                entries[i * vertices.size() + j] = dist(vertices[i], vertices[j]);
+            }
+        }
+        return problem;
+    }
+
+    problem.coordinates.reserve(vertices.size() * coordinatesPerVertex);
+    for (vertex_t v : vertices) {
+        problem.coordinates.insert(problem.coordinates.end(),
+                                   coordinates.begin() + static_cast<std::ptrdiff_t>(v * coordinatesPerVertex),
+                                   coordinates.begin() + static_cast<std::ptrdiff_t>((v + 1) * coordinatesPerVertex));
+    }
+    problem.prepareDistances();
+    return problem;
+}
+
+void TsplibProblem::renumber(const std::vector<vertex_t> &order) {
+    std::vector<std::size_t> newOriginalOffsets{0};
+    std::vector<vertex_t> newOriginalVertices;
+    newOriginalVertices.reserve(originalVertices.empty() ? dimension : originalVertices.size());
+    for (vertex_t v : order) {
+        if (originalOffsets.empty()) {
+            newOriginalVertices.push_back(v);
+        } else {
+            newOriginalVertices.insert(newOriginalVertices.end(), originalVertices.begin() + originalOffsets[v],
+                                       originalVertices.begin() + originalOffsets[v + 1]);
+        }
+        newOriginalOffsets.push_back(newOriginalVertices.size());
+    }
+    originalOffsets.swap(newOriginalOffsets);
+    originalVertices.swap(newOriginalVertices);
+
+    if (edgeWeightType == EXPLICIT) {
+        // Copy the matrix in the new order, the layout stays the same
+        const std::shared_ptr<const distance_t> oldMatrix = matrix;
+        const distance_t *oldEntries = oldMatrix.get();
+        const dimension_t n = dimension;
+        if (matrixLayout == FULL) {
+            distance_t *entries = allocateFullMatrix();
+            for (vertex_t i = 0; i < n; ++i) {
+                const distance_t *oldRow = oldEntries + order[i] * n;
+                for (vertex_t j = 0; j < n; ++j) {
+                    entries[i * n + j] = oldRow[order[j]];
+                }
+            }
+        } else {
+            distance_t *entries = allocateTriangularMatrix();
+            for (vertex_t i = 0; i < n; ++i) {
+                for (vertex_t j = 0; j <= i; ++j) {
+                    const vertex_t v = std::max(order[i], order[j]), w = std::min(order[i], order[j]);
+                    entries[i * (i + 1) / 2 + j] = oldEntries[v * (v + 1) / 2 + w];
+                }
+            }
+        }
+        return;
+    }
+
+    std::vector<double> oldCoordinates;
+    oldCoordinates.swap(coordinates);
+    coordinates.reserve(oldCoordinates.size());
+    for (vertex_t v : order) {
+        coordinates.insert(coordinates.end(), oldCoordinates.begin() + v * coordinatesPerVertex,
+                           oldCoordinates.begin() + (v + 1) * coordinatesPerVertex);
+    }
+
+    // Release the old storage before the new one is allocated
+    matrix.reset();
+    distanceCache.reset();
+    prepareDistances();
+}
+
+dimension_t TsplibProblem::mergeDuplicates(dimension_t minimumDimension) {
+    if (edgeWeightType == EXPLICIT or dimension == 0) {
+        return 0;
+    }
+
+    // Sort the vertices by their coordinates, so that vertices with the same coordinates are next to each other
+    auto coordinatesOf = [this](vertex_t v) { return coordinates.begin() + v * coordinatesPerVertex; };
+    std::vector<vertex_t> sortedVertices(dimension);
+    std::iota(sortedVertices.begin(), sortedVertices.end(), 0);
+    std::stable_sort(sortedVertices.begin(), sortedVertices.end(), [&](vertex_t v, vertex_t w) {
+        return std::lexicographical_compare(coordinatesOf(v), coordinatesOf(v) + coordinatesPerVertex,
+                                            coordinatesOf(w), coordinatesOf(w) + coordinatesPerVertex);
+    });
+
+    // representative[v] is the vertex with the smallest number that has the same coordinates as v
+    std::vector<vertex_t> representative(dimension);
+    dimension_t removedVertices = 0;
+    representative[sortedVertices[0]] = sortedVertices[0];
+    for (std::size_t index = 1; index < dimension; ++index) {
+        const vertex_t v = sortedVertices[index];
+        const vertex_t previous = representative[sortedVertices[index - 1]];
+        if (std::equal(coordinatesOf(v), coordinatesOf(v) + coordinatesPerVertex, coordinatesOf(previous)) and
+            trueDistance(v, previous) == 0) {
+            representative[v] = previous;
+            ++removedVertices;
+        } else {
+            representative[v] = v;
+        }
+    }
+    if (removedVertices == 0 or dimension - removedVertices < minimumDimension) {
+        return 0;
+    }
+
+    // The remaining vertices keep their order, newVertex maps them to their new number
+    std::vector<vertex_t> newVertex(dimension);
+    std::vector<double> newCoordinates;
+    newCoordinates.reserve((dimension - removedVertices) * coordinatesPerVertex);
+    dimension_t newDimension = 0;
+    for (vertex_t v = 0; v < dimension; ++v) {
+        if (representative[v] == v) {
+            newVertex[v] = newDimension++;
+            newCoordinates.insert(newCoordinates.end(), coordinatesOf(v), coordinatesOf(v) + coordinatesPerVertex);
+        }
+    }
+
+    // Collect the original vertices of all vertices merged into each new vertex
+    std::vector<std::size_t> newOriginalOffsets(newDimension + 1, 0);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        const std::size_t count = originalOffsets.empty() ? 1 : originalOffsets[v + 1] - originalOffsets[v];
+        newOriginalOffsets[newVertex[representative[v]] + 1] += count;
+    }
+    std::partial_sum(newOriginalOffsets.begin(), newOriginalOffsets.end(), newOriginalOffsets.begin());
+    std::vector<vertex_t> newOriginalVertices(newOriginalOffsets.back());
+    std::vector<std::size_t> position(newOriginalOffsets.begin(), newOriginalOffsets.end() - 1);
+    for (vertex_t v = 0; v < dimension; ++v) {
+        std::size_t &next = position[newVertex[representative[v]]];
+        if (originalOffsets.empty()) {
+            newOriginalVertices[next++] = v;
+        } else {
+            for (std::size_t i = originalOffsets[v]; i < originalOffsets[v + 1]; ++i) {
+                newOriginalVertices[next++] = originalVertices[i];
+            }
+        }
+    }
+
+    dimension = newDimension;
+    coordinates.swap(newCoordinates);
+    originalOffsets.swap(newOriginalOffsets);
+    originalVertices.swap(newOriginalVertices);
+
+    // Release the old storage before the new one is allocated
+    matrix.reset();
+    distanceCache.reset();
+    prepareDistances();
+    return removedVertices;
+}
+
+vertex_t TsplibProblem::getOriginalVertex(vertex_t v) const {
+    return originalOffsets.empty() ? v : originalVertices[originalOffsets[v]];
+}
+
+Tour TsplibProblem::originalTour(const Tour &tour) const {
+    if (originalOffsets.empty()) {
+        return tour;
+    }
+    std::vector<vertex_t> tourSequence;
+    tourSequence.reserve(originalVertices.size());
+    vertex_t currentVertex = 0;
+    do {
+        tourSequence.insert(tourSequence.end(), originalVertices.begin() + originalOffsets[currentVertex],
+                            originalVertices.begin() + originalOffsets[currentVertex + 1]);
+        currentVertex = tour.successor(currentVertex);
+    } while (currentVertex != 0);
+    return Tour(tourSequence);
+}
+
 distance_t TsplibProblem::length(const BaseTour &tour) const {
     distance_t sum = 0;
 
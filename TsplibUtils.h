@@ -6,8 +6,12 @@
 #define LINKERNIGHANALGORITHM_TSPLIBUTILS_H
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
+#include "DistanceCache.h"
+#include "MappedFile.h"
+#include "Scanner.h"
 #include "Tour.h"
 
 
@@ -19,6 +23,12 @@ std::string trim(const std::string &str, const std::string &whitespace = " \t");
 // or unsupported keywords
 
 class TsplibProblem {
+public:
+    // The supported values of EDGE_WEIGHT_TYPE, see the TSPLIB documentation for the distance functions
+    enum EdgeWeightType {
+        UNSPECIFIED, EXPLICIT, EUC_2D, EUC_3D, MAX_2D, MAX_3D, MAN_2D, MAN_3D, CEIL_2D, GEO, ATT
+    };
+
 private:
     // The delimiter between a keyword and its value, used in the TSPLIB format
     static const char DELIMITER = ':';
@@ -27,37 +37,131 @@ private:
     std::string name;
     std::string type;
     dimension_t dimension = 0;
-    std::string edgeWeightType;
+    EdgeWeightType edgeWeightType = UNSPECIFIED;
     std::string edgeWeightFormat;
-    std::string nodeCoordType = "TWOD_COORDS";
+
+    // The ways the distance matrix can be stored
+    enum MatrixLayout {
+        // Row by row, the distance of i and j is matrix[i * dimension + j]
+        FULL,
+        // Only the lower triangle including the diagonal row by row, the distance of i >= j is
+        // matrix[i * (i + 1) / 2 + j]. This layout is used for matrices loaded from binary files
+        LOWER_TRIANGULAR
+    };
 
     // If EDGE_WEIGHT_TYPE is EXPLICIT or storeAllDistances is true this matrix contains all pairs of distances
-    std::vector<std::vector<distance_t>> matrix;
+    // The matrix is shared between copies of the problem and may point into a memory-mapped binary file
+    std::shared_ptr<const distance_t> matrix;
+    MatrixLayout matrixLayout = FULL;
+
+    // If the EDGE_WEIGHT_TYPE is not EXPLICIT this vector stores the coordinates of all vertices one after another,
+    // i.e. coordinate c of vertex i is coordinates[i * coordinatesPerVertex + c]
+    std::vector<double> coordinates;
+    std::size_t coordinatesPerVertex = 2;
 
-    // If EDGE_WEIGHT_TYPE is *_2D this vector stores all 2D coordinates
-    std::vector<std::vector<double>> coordinates;
+    // For GEO the latitude and longitude of every vertex in radians, they are computed once from the coordinates
+    std::vector<double> geoRadians;
 
     // When the EDGE_WEIGHT_TYPE is not EXPLICIT, this parameter specifies whether all distances should be computed
     // and stored in a matrix or only the coordinates should be saved. In the latter case the distances will be computed
     // on every call to TsplibProblem::dist. This is a trade-off between running time and memory usage
     bool storeAllDistances = true;
 
+    // If storeAllDistances is false and distanceCacheBytes is not 0, distanceCache caches the distances in at most
+    // distanceCacheBytes bytes. The cache is shared between copies of the problem
+    std::size_t distanceCacheBytes = 0;
+    std::shared_ptr<DistanceCache> distanceCache;
+
+    // If the vertices were renumbered or merged, vertex v represents the vertices originalVertices[originalOffsets[v]],
+    // ..., originalVertices[originalOffsets[v + 1] - 1] of the TSPLIB file. Otherwise both vectors are empty
+    std::vector<std::size_t> originalOffsets;
+    std::vector<vertex_t> originalVertices;
+
+    // If storeAllDistances is true, store only the lower triangle of the matrix (see MatrixLayout). This halves the
+    // memory of the matrix, but the computation of the index is a bit slower
+    bool triangularMatrix = false;
+
     // Interpret a single keyword value pair from the specification part of a TSPLIB file
     // Expects keyword and value to not have any superfluous whitespaces or line breaks
     // Returns an error message if an error occurred and an empty string otherwise
     std::string interpretKeyword(const std::string &keyword, const std::string &value);
 
+    // Interpret the characters in [begin, end) as a TSPLIB file, see readFile
+    std::string parse(const char *begin, const char *end);
+
+    // Read the coordinates after NODE_COORD_SECTION until the next keyword
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string readNodeCoordSection(Scanner &scanner);
+
+    // Read the numbers after EDGE_WEIGHT_SECTION and write them directly into the matrix
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string readEdgeWeightSection(Scanner &scanner);
+
+    // Returns the entry of the matrix for vertex i and vertex j
+    distance_t matrixEntry(vertex_t i, vertex_t j) const {
+        if (matrixLayout == FULL) {
+            return matrix.get()[i * dimension + j];
+        } else {
+            return i >= j ? matrix.get()[i * (i + 1) / 2 + j] : matrix.get()[j * (j + 1) / 2 + i];
+        }
+    }
+
+    // Allocates a zero-initialized matrix with the FULL layout, stores it in matrix and returns a pointer to its data
+    distance_t *allocateFullMatrix();
+
+    // Allocates a zero-initialized matrix with the LOWER_TRIANGULAR layout, stores it in matrix and returns a pointer
+    // to its data
+    distance_t *allocateTriangularMatrix();
+
+    // Set the EDGE_WEIGHT_TYPE with the given name and coordinatesPerVertex accordingly
+    // Returns false if the name is not a supported EDGE_WEIGHT_TYPE
+    bool setEdgeWeightType(const std::string &edgeWeightTypeName);
+
+    // Prepare everything the distance function needs after the coordinates were read: the radians for GEO and the
+    // matrix of all distances or the distance cache
+    void prepareDistances();
+
     // Computes the distance of vertex i and vertex j even if storeAllDistances is true
     // Expects that i and j are in [0, dimension)
     distance_t trueDistance(vertex_t i, vertex_t j) const;
 
+    // Computes the distances of all pairs of vertices from the coordinates and stores them in matrix
+    void computeAllDistances();
+
 public:
-    explicit TsplibProblem(bool storeAllDistances = true);
+    // See storeAllDistances and distanceCacheBytes
+    explicit TsplibProblem(bool storeAllDistances = true, std::size_t distanceCacheBytes = 0);
+
+    // Construct a TSPLIB problem from the coordinates of its vertices
+    // Expects that edgeWeightType is not EXPLICIT and that every vertex has as many coordinates as edgeWeightType needs
+    static TsplibProblem fromCoordinates(std::string name, EdgeWeightType edgeWeightType,
+                                         const std::vector<std::vector<double>> &coordinates,
+                                         bool storeAllDistances = true);
+
+    // Returns the name of an EDGE_WEIGHT_TYPE as it is used in TSPLIB files
+    static const char *getName(EdgeWeightType edgeWeightType);
 
     // Interpret the file inputFile as a TSPLIB file and store the information given there
     // Returns an error message if an error occurred and an empty string otherwise
     std::string readFile(std::ifstream &inputFile);
 
+    // Interpret the memory-mapped file inputFile as a TSPLIB file, this avoids copying the file
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string readFile(const MappedFile &inputFile);
+
+    // Returns whether inputFile is in the binary format written by writeBinaryFile
+    static bool isBinaryFile(const MappedFile &inputFile);
+
+    // Interpret inputFile as a binary file written by writeBinaryFile. A distance matrix in the file is used directly
+    // without copying, so inputFile is kept open as long as this problem (or a copy of it) exists
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string readBinaryFile(MappedFile inputFile);
+
+    // Write the problem in a binary format that can be loaded without parsing. Problems with coordinates are stored as
+    // an array of coordinates, EXPLICIT problems as the lower triangle of the distance matrix.
+    // Returns an error message if an error occurred and an empty string otherwise
+    std::string writeBinaryFile(const std::string &fileName) const;
+
     // Returns the name of the TSPLIB problem
     const std::string &getName() const;
 
@@ -67,10 +171,66 @@ public:
     // Returns the number of vertices in the TSPLIB problem
     dimension_t getDimension() const;
 
+    // Returns the EDGE_WEIGHT_TYPE of the TSPLIB problem
+    EdgeWeightType getEdgeWeightType() const;
+
+    // Returns the number of bytes used by the stored distance matrix (0 if there is none)
+    std::size_t getMatrixBytes() const;
+
+    // Change how the distances are stored after the problem was read, e.g. when the choice depends on the dimension
+    // The parameters have the same meaning as storeAllDistances, distanceCacheBytes and triangularMatrix. EXPLICIT
+    // problems always keep the matrix they were read with
+    void setDistanceStorage(bool storeAllDistances, std::size_t distanceCacheBytes, bool triangularMatrix);
+
     // Returns the distance of vertex i and vertex j
     // Expects that i and j are in [0, dimension)
     distance_t dist(vertex_t i, vertex_t j) const;
 
+    // If distances are cached, store the distances from every vertex v to neighbors[v] permanently in the cache
+    void cacheNeighborDistances(const std::vector<std::vector<vertex_t>> &neighbors);
+
+    // Returns an order of all vertices in which vertices that are close to each other are mostly close in the order as
+    // well. Problems with coordinates are ordered along a Hilbert curve through the first two coordinates, EXPLICIT
+    // problems by a depth-first search of a minimum spanning tree
+    std::vector<vertex_t> localityOrder() const;
+
+    // Returns the k nearest neighbors of every vertex ordered by distance without computing all distances. The vertices
+    // are sorted into a grid over the first two coordinates with about two vertices per cell, and the cells around a
+    // vertex are searched ring by ring until no vertex in a further ring can be nearer. Returns an empty vector for
+    // EXPLICIT and GEO problems, their distances give no bound from the grid
+    std::vector<std::vector<vertex_t>> gridNearestNeighbors(std::size_t k) const;
+
+    // Partition the vertices into cells of at most maxCellSize vertices. Problems with coordinates are partitioned by
+    // Karp's method: the bounding box of the first two coordinates is cut at the median of its longer side until every
+    // cell is small enough. EXPLICIT problems are cut into consecutive parts of localityOrder. The cells are ordered by
+    // the mean position of their vertices in localityOrder, so consecutive cells are mostly close to each other
+    // Expects maxCellSize > 0
+    std::vector<std::vector<vertex_t>> partition(dimension_t maxCellSize) const;
+
+    // Returns the problem that only contains the given vertices, vertex i of the subproblem is vertices[i] of this
+    // problem. The subproblem stores all distances in a matrix, unless storeAllDistances is false and the problem is
+    // not EXPLICIT, then it computes them from the coordinates like a problem with storeAllDistances set to false
+    TsplibProblem subproblem(const std::vector<vertex_t> &vertices, bool storeAllDistances = true) const;
+
+    // Renumber the vertices, such that vertex order[v] becomes vertex v. Expects that order is a permutation of all
+    // vertices. The distances are stored in the same way as before, a stored matrix is computed or copied again
+    void renumber(const std::vector<vertex_t> &order);
+
+    // Merge all vertices with the same coordinates into one vertex, if their distance is 0 (this excludes GEO, where
+    // the distance of equal coordinates is 1). Every tour of the merged problem gives a tour of the same length of the
+    // original problem by visiting the merged vertices one after another, so an optimum tour stays optimum
+    // Nothing is merged for EXPLICIT problems or if less than minimumDimension vertices would remain
+    // Returns the number of vertices that were removed
+    dimension_t mergeDuplicates(dimension_t minimumDimension);
+
+    // Returns the number of the vertex in the TSPLIB file that v represents, the first one if v represents several
+    // merged vertices
+    vertex_t getOriginalVertex(vertex_t v) const;
+
+    // Returns tour with the numbers of the vertices in the TSPLIB file, e.g. to output a tour of a renumbered problem
+    // Merged vertices are visited one after another
+    Tour originalTour(const Tour &tour) const;
+
     // Returns the length of tour
     distance_t length(const BaseTour &tour) const;
 
@@ -2,12 +2,14 @@
 // Created by Karl Welzel on 25.03.19.
 //
 
-#include <cstddef>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
-#include "LinKernighanHeuristic.h"
+#include "Solver.h"
+#include "Statistics.h"
 #include "Tour.h"
 #include "TsplibUtils.h"
 
@@ -19,7 +21,8 @@ Usage:
 
 Options:
     --number-of-trials=integer
-        Sets the maximum number of trials (default: 50)
+        Sets the maximum number of trials (default: 50). Problems with at most 16 vertices are solved exactly by
+        dynamic programming instead.
     --candidate-edges=[ALL|NEAREST|ALPHA_NEAREST|OPT_ALPHA_NEAREST]
         Set the choice of candidate edges for each vertex (default: OPT_ALPHA_NEAREST)
             ALL: all incident edges
@@ -31,16 +34,120 @@ Options:
     --dont-store-distances
         The distances between all vertices are not computed once and then stored in a matrix, but are computed when
         needed. This leads to fewer memory usage but also to a considerable decrease in performance.
+    --distance-cache-mb=integer
+        Do not store all distances (see --dont-store-distances), but cache them in at most the given number of MB. The
+        distances of the candidate edges are always kept, the rest of the memory is used for recently used distances.
+    --memory-limit=integer
+        Limit the estimated memory usage to the given number of MB. Depending on the dimension the distances are
+        stored in a full or triangular matrix, cached (see --distance-cache-mb) or computed when needed, and the alpha
+        distances are stored in dense tables or computed row by row. Overrides --dont-store-distances and
+        --distance-cache-mb. The chosen plan is shown with --verbose.
+    --renumber-vertices
+        Renumber the vertices, such that vertices close to each other get similar numbers (along a Hilbert curve or
+        for EXPLICIT problems by a depth-first search of a minimum spanning tree). This improves the cache usage on
+        large problems. The tour is output with the original numbers.
+    --merge-duplicates
+        Merge vertices with the same coordinates into one vertex before solving the problem. The merged vertices are
+        visited one after another in the output tour, which does not change its length. Not used for EXPLICIT and GEO
+        problems.
+    --mode=[LK|FAST|FAST_LK]
+        Set how the tour of every trial is improved (default: LK)
+            LK: search improving moves made of steps of the --move-type
+            FAST: only search 2-opt and Or-opt moves with candidate edges and don't-look bits. This gives a good tour
+                  within milliseconds, but worse than the other modes.
+            FAST_LK: use FAST first and then LK on the result
+    --move-type=[LK|5OPT]
+        Set the basic step of the search (default: LK)
+            LK: add and remove one edge in every step
+            5OPT: add and remove up to five edges in every step, chosen by an exhaustive search over the candidate
+                  edges. The steps are much slower but find better tours.
+    --backtracking-depth=integer
+        Set the depth up to which the search backtracks if no improvement was found, i.e. the search tries all
+        alternatives for the first integer vertices of an alternating walk. (default: 5)
+    --infeasibility-depth=integer
+        Set the depth up to which an alternating walk may be extended although closing it does not give a tour.
+        (default: 2)
+    --max-move-depth=integer
+        Set the maximum number of edges exchanged by a single move, e.g. 3 only allows 2-opt and 3-opt moves. The
+        value must be at least 2. (default: 0, no limit)
+    --candidate-order=[REVERSE_ALPHA|ALPHA|LOOKAHEAD]
+        Set the order in which the candidate edges are tried as the next edge of an alternating walk. Without the
+        pathological brg180 ALPHA gives the lowest mean gap on the default benchmark suite, LOOKAHEAD is the fastest
+        (see Benchmarks/candidate_order.txt).
+        (default: ALPHA)
+            REVERSE_ALPHA: by decreasing alpha distance, i.e. in the reverse order of the candidate edges (the order
+                           before this option was added)
+            ALPHA: by alpha distance, i.e. in the order of the candidate edges
+            LOOKAHEAD: by the gain after the next edge is removed from the tour, g - c(x_i, x_i+1) + c(x_i+1, x_i+2)
+    --breadth=integer,integer,...
+        Limit the number of candidate edges tried as the first, second, ... added edge of an alternating walk, the
+        last number is used for all following edges, e.g. 5,3,1. Every number must be at least 1. (default: no limit)
+    --group-size=integer
+        Set the number of vertices in a segment of the tour (see Tour.h). (default: depending on the dimension)
+    --tour-merging
+        Merge the tour of every trial with the best tour found so far by a partition crossover: both tours are cut
+        into parts that they visit between the same two vertices, and the shorter version of every part is used.
+    --backbone-tours=integer
+        Prefer the edges that are contained in most of the tours of the last integer trials when generating the start
+        tour of a trial, instead of the edges of the best tour. (default: 0, only the best tour)
+    --fix-backbone
+        Never remove an edge from the tour that is contained in all of the last --backbone-tours distinct trial tours
+        (at least two), a trial that returns one of these tours again releases them for the next trial. This makes
+        the later trials faster but may prevent finding the optimum.
+    --dont-look-bits
+        Only start the search from a vertex again after one of its tour edges changed, instead of starting it from
+        every vertex again after each improvement. This makes a trial much faster on large problems, but its tour is
+        worse unless the start tour is already good (see --multilevel). --mode=FAST always uses them.
+    --partition-size=integer
+        Solve problems with more than integer vertices by partitioning them into cells of at most integer vertices (see
+        TsplibProblem::partition). Every cell is solved with --number-of-trials trials and don't-look bits, so all cells
+        together take about as long as --number-of-trials trials of the whole problem with --dont-look-bits. Can not be
+        used with --candidate-edges=OPT_ALPHA_NEAREST, its subgradient optimization would take longer than the search of
+        a cell. The cells are solved in parallel. Then the tours of the cells are joined and improved by a search with
+        don't-look bits from the vertices at the borders of the cells. The candidate edges of the whole problem are the
+        nearest neighbors found with a grid and the distances are not stored in a matrix, so the time and memory outside
+        of the cells stay almost linear. --optimum-tour-length and --acceptable-error do not stop the search.
+        (default: 0, no partitioning)
+    --multilevel=integer
+        Solve problems with more than integer vertices by a multi-level approach: the vertices are matched in pairs
+        along candidate edges and every pair is replaced by one of its vertices, until at most integer vertices
+        remain. The coarsest problem is solved with --number-of-trials trials, then the tour is expanded level by
+        level and improved by a single search with --dont-look-bits on every level. Only the coarsest problem gets
+        candidate edges of --candidate-edges, the whole problem gets the nearest neighbors found with a grid and
+        no distance matrix, and every coarser problem the candidate edges mapped from the finer one.
+        --optimum-tour-length and --acceptable-error do not stop the search. Not used with --partition-size.
+        (default: 0, no multi-level)
+    --segment-size=integer
+        Improve the best tour by cutting it into segments of integer vertices and re-optimizing the path through every
+        segment between its two ends with --number-of-trials trials, the segments are solved in parallel. This is done
+        twice, the second time with segments shifted by half of integer. The ends are kept by a fixed edge.
+        (default: 0, no segment optimization)
+    --window-size=integer
+        Slide a window of integer consecutive vertices over the final tour and reorder the vertices inside of every
+        window optimally by dynamic programming, the first and the last vertex of the window stay in place. The time
+        grows exponentially, integer must be between 4 and 18. (default: 0, no windows)
+    --threads=integer
+        Set the number of threads that solve the cells of --partition-size and the segments of --segment-size
+        (default: 0, one for every hardware thread)
     --optimum-tour-length=integer
         Set the optimum tour length for the problem. The output will include the percentage error of the solution.
     --acceptable-error=double
         Set the acceptable error compared to the optimum length in percent. The program will stop when a found tour
         is within the acceptable length range. Ignored if --optimum-value is not given. (default: 0)
+    --seed=integer
+        Set the seed of the random number generator. Runs with the same seed and options give the same tour.
+        (default: random)
     --output-to-file
         Output the best tour found to "tsplib_problem.lk.tour"
     --verbose
         Output debug output, useful to estimate the remaining running time. If not given there is no output until the
         result is computed.
+    --stats-json=path
+        Write the running time of each phase and the operation counters of the algorithm as JSON to path. The values
+        are only collected if the program was compiled with the CMake option LK_STATISTICS=ON.
+    --export-binary=path
+        Write the problem in a binary format to path and exit without solving it. The binary file can be given instead
+        of the TSPLIB file and is loaded without any parsing, explicit distances are stored as a triangular matrix.
 
 Example:
     LinKernighanAlgorithm si1032.tsp --optimum-tour-length=92650 --acceptable-error=0.1 --output-to-file --verbose
@@ -57,15 +164,13 @@ Restrictions:
         std::cout << helpString;
     }
 
-    // Set the default option values
-    std::size_t numberOfTrials = 50;
-    CandidateEdges::Type candidateEdgeType = CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS;
-    std::size_t numberOfCandidateEdges = 5;
-    bool storeAllDistances = true;
-    distance_t optimumTourLength = 0;
-    double acceptableError = 0;
+    // Set the default option values, the options of the solver are in SolverOptions
+    SolverOptions options;
+    options.seed = std::random_device{}();
     bool outputToFile = false;
     bool verboseOutput = false;
+    std::string statisticsFileName;
+    std::string binaryFileName;
 
     // Read the command line options
     std::stringstream stringStream;
@@ -76,95 +181,98 @@ Restrictions:
             stringStream.clear();
             continue;
         }
-        if (option == "--number-of-trials") {
-            stringStream >> numberOfTrials;
-        } else if (option == "--candidate-edges") {
-            std::string type;
-            std::getline(stringStream, type);
-            if (type == "ALL") {
-                candidateEdgeType = CandidateEdges::ALL_NEIGHBORS;
-            } else if (type == "NEAREST") {
-                candidateEdgeType = CandidateEdges::NEAREST_NEIGHBORS;
-            } else if (type == "ALPHA_NEAREST") {
-                candidateEdgeType = CandidateEdges::ALPHA_NEAREST_NEIGHBORS;
-            } else if (type == "OPT_ALPHA_NEAREST") {
-                candidateEdgeType = CandidateEdges::OPTIMIZED_ALPHA_NEAREST_NEIGHBORS;
-            } else {
-                std::cerr << "The --candidate-edges type '" << type << "' is not valid" << std::endl;
-                std::cout << helpString;
-                return 1;
-            }
-        } else if (option == "--number-of-candidate-edges") {
-            stringStream >> numberOfCandidateEdges;
-        } else if (option == "--dont-store-distances") {
-            storeAllDistances = false;
-        } else if (option == "--optimum-tour-length") {
-            stringStream >> optimumTourLength;
-        } else if (option == "--acceptable-error") {
-            stringStream >> acceptableError;
+        std::string errorMessage;
+        if (option == "--optimum-tour-length") {
+            stringStream >> options.optimumTourLength;
+        } else if (option == "--seed") {
+            stringStream >> options.seed;
         } else if (option == "--output-to-file") {
             outputToFile = true;
         } else if (option == "--verbose") {
             verboseOutput = true;
+        } else if (option == "--stats-json") {
+            std::getline(stringStream, statisticsFileName);
+        } else if (option == "--export-binary") {
+            std::getline(stringStream, binaryFileName);
         } else {
-            std::cerr << "An unknown option was given" << std::endl;
-            std::cout << helpString;
-            return 1;
+            errorMessage = options.readOption(option, stringStream);
         }
-        if (stringStream.fail()) {
-            std::cerr << "One of the options has an invalid format" << std::endl;
+        if (errorMessage.empty() and stringStream.fail()) {
+            errorMessage = "The option '" + option + "' has an invalid format";
+        }
+        if (!errorMessage.empty()) {
+            std::cerr << errorMessage << std::endl;
             std::cout << helpString;
             return 1;
         }
         stringStream.clear();
     }
 
-    // Try to open the TSPLIB file
-    std::ifstream problemFile(argv[1]);
-    if (!problemFile.is_open() or !problemFile.good()) {
-        std::cerr << "Could not open the TSPLIB file '" << argv[1] << "'" << std::endl;
+    std::string errorMessage = options.validate();
+    if (!errorMessage.empty()) {
+        std::cerr << errorMessage << std::endl;
+        std::cout << helpString;
         return 1;
     }
 
     // Interpret the problem file and report any syntax errors, logical errors or unsupported keywords
-    TsplibProblem problem(storeAllDistances);
-    std::string errorMessage = problem.readFile(problemFile);
-    problemFile.close();
+    TsplibProblem problem;
+    errorMessage = readProblem(argv[1], options, problem);
     if (!errorMessage.empty()) {
-        std::cerr << "The TSPLIB file has an invalid format: " << errorMessage
-                  << std::endl;
+        std::cerr << errorMessage << std::endl;
         return 1;
     }
 
-    if (verboseOutput) std::cout << "Opened the " << problem.getName() << " TSPLIB file" << std::endl;
-
-    CandidateEdges candidateEdges = CandidateEdges::create(problem, candidateEdgeType, numberOfCandidateEdges);
+    if (!binaryFileName.empty()) {
+        errorMessage = problem.writeBinaryFile(binaryFileName);
+        if (!errorMessage.empty()) {
+            std::cerr << "Could not export the binary problem file: " << errorMessage << std::endl;
+            return 1;
+        }
+        if (verboseOutput) std::cout << "Successfully written the binary problem to '" << binaryFileName << "'"
+                                     << std::endl;
+        return 0;
+    }
 
-    if (verboseOutput) std::cout << "Computed candidate edges" << std::endl;
+    if (verboseOutput) std::cout << "Opened the " << problem.getName() << " TSPLIB file" << std::endl;
 
-    LinKernighanHeuristic heuristic(problem, candidateEdges);
-    const Tour tour = heuristic.findBestTour(numberOfTrials, optimumTourLength, acceptableError / 100, verboseOutput);
+    const Tour tour = solve(problem, options, verboseOutput).tour;
 
     // Output the best tour found by the algorithm
     std::string tourName = problem.getName() + ".lk.tour";
+    TsplibTour tsplibTour(tourName, problem.originalTour(tour));
     if (outputToFile) {
         std::ofstream outputFile(tourName);
-        outputFile << TsplibTour(tourName, tour).toTsplibTourFile() << std::endl;
+        outputFile << tsplibTour.toTsplibTourFile() << std::endl;
         outputFile.close();
 
         if (verboseOutput) std::cout << "Successfully written the tour to '" << tourName << "'" << std::endl;
     } else {
-        std::cout << std::endl << TsplibTour(tourName, tour).toTsplibTourFile() << std::endl;
+        std::cout << std::endl << tsplibTour.toTsplibTourFile() << std::endl;
     }
 
     // Compare the tour length to the length of the optimal tour if given
     distance_t length = problem.length(tour);
-    if (optimumTourLength == 0) {
+    if (options.optimumTourLength == 0) {
         std::cout << "The shortest tour found is " << length << " units long." << std::endl;
     } else {
         std::cout << "The shortest tour found is " << length << " units long, so "
-                  << ((length / (double) optimumTourLength) - 1) * 100 << "% above the optimum of " << optimumTourLength
-                  << "." << std::endl;
+                  << ((length / (double) options.optimumTourLength) - 1) * 100 << "% above the optimum of "
+                  << options.optimumTourLength << "." << std::endl;
+    }
+
+    // Output the collected statistics
+    if (!statisticsFileName.empty()) {
+        if (!Statistics::isEnabled()) {
+            std::cerr << "No statistics were collected, because the program was compiled without LK_STATISTICS"
+                      << std::endl;
+        }
+        std::ofstream statisticsFile(statisticsFileName);
+        statisticsFile << Statistics::toJson();
+        statisticsFile.close();
+
+        if (verboseOutput) std::cout << "Successfully written the statistics to '" << statisticsFileName << "'"
+                                     << std::endl;
     }
 
     return 0;